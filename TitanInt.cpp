@@ -1,591 +1,6279 @@
 #include <iostream>
+#include <ostream>
 #include <string>
 #include <cstdint>
 #include <vector>
 #include <stdexcept>
 #include <algorithm>
 #include <limits>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <type_traits>
+#include <cmath>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <cstdlib>
+#include <list>
+#include <deque>
+#include <memory>
+#if __cplusplus >= 202002L
+#include <compare>
+#endif
+#ifdef TITANINT_PROPERTY_TESTS
+#include <random>
+#endif
+#ifdef __linux__
+#include <csignal>
+#include <cerrno>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
-class BigInt;
-BigInt operator+(BigInt lhs, const BigInt &rhs);
-BigInt operator-(BigInt lhs, const BigInt &rhs);
-BigInt operator*(BigInt lhs, const BigInt &rhs);
-BigInt operator/(BigInt lhs, const BigInt &rhs);
-BigInt operator%(BigInt lhs, const BigInt &rhs);
+// ==================== INSTRUMENTATION ====================
+// Opt-in hot-path instrumentation. Build with -DTITANINT_INSTRUMENT to record
+// per-operator call counts, operand size histograms, algorithm tier, time and
+// bytes allocated (through a replacement operator new). Counters live in per-thread slots, so recording never takes
+// a lock; snapshot() sums every slot that was ever registered. Without the
+// flag every TITAN_* macro expands to nothing.
+#ifdef TITANINT_INSTRUMENT
 
-class BigInt
+namespace titan_stats
 {
-    string number;   // Stores the number as a string
-    bool isNegative; // True if number is negative
-
-public:
-    // Moved function (removeLeadingZeros,compareMagnitude) to public for declaration and external access
-    // Remove unnecessary leading zeros from the number string
-    void removeLeadingZeros()
+    enum Op
+    {
+        OP_ADD,
+        OP_SUB,
+        OP_MUL,
+        OP_DIV,
+        OP_MOD,
+        OP_COMPARE,
+        OP_GET_NUMBER,
+        OP_COUNT
+    };
+
+    enum Tier
     {
-        int i = 0;
-        while (i < number.length() && number[i] == '0')
+        TIER_SCHOOLBOOK,
+        TIER_KARATSUBA,
+        TIER_SCALAR,
+        TIER_NEWTON,
+        TIER_COUNT
+    };
+
+    static const char *const opNames[OP_COUNT] = {"add", "sub", "mul", "div", "mod", "compareMagnitude", "getNumber"};
+    static const char *const tierNames[TIER_COUNT] = {"schoolbook", "karatsuba", "scalar", "newton"};
+
+    // Bucket i counts operands with a digit count in [2^i, 2^(i+1))
+    const int SIZE_BUCKETS = 32;
+    // Trace events kept per thread before new regions are dropped
+    const size_t MAX_TRACE_EVENTS = 1 << 20;
+
+    inline int sizeBucket(size_t digits)
+    {
+        int bucket = 0;
+        while (digits > 1 && bucket < SIZE_BUCKETS - 1)
         {
-            ++i;
+            digits >>= 1;
+            ++bucket;
         }
-        number.erase(0, i);
-        if (number.empty())
+        return bucket;
+    }
+
+    inline uint64_t nowNanos()
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Counters are written only by their owning thread; relaxed atomics keep
+    // snapshot() free of data races without putting a lock on the hot path.
+    struct Counter
+    {
+        atomic<uint64_t> value{0};
+        void add(uint64_t n) { value.store(value.load(memory_order_relaxed) + n, memory_order_relaxed); }
+        uint64_t get() const { return value.load(memory_order_relaxed); }
+    };
+
+    struct OpCounters
+    {
+        Counter calls;
+        Counter nanos;
+        Counter bytes;
+        Counter sizeHistogram[SIZE_BUCKETS];
+        Counter tiers[TIER_COUNT];
+    };
+
+    struct TraceEvent
+    {
+        const char *name;
+        uint64_t startNanos;
+        uint64_t durationNanos;
+    };
+
+    struct ThreadSlot
+    {
+        uint64_t threadId;
+        OpCounters ops[OP_COUNT];
+        mutex traceMutex; // only contended while a dump is running
+        vector<TraceEvent> trace;
+    };
+
+    struct Registry
+    {
+        mutex lock;
+        vector<shared_ptr<ThreadSlot>> slots; // slots outlive their threads
+        uint64_t nextThreadId = 0;
+        uint64_t epochNanos = nowNanos();
+    };
+
+    inline Registry &registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    inline ThreadSlot &localSlot()
+    {
+        thread_local shared_ptr<ThreadSlot> slot;
+        if (!slot)
         {
-            number = "0";
-            isNegative = false;
+            slot = make_shared<ThreadSlot>();
+            Registry &reg = registry();
+            lock_guard<mutex> guard(reg.lock);
+            slot->threadId = reg.nextThreadId++;
+            reg.slots.push_back(slot);
         }
+        return *slot;
     }
 
-    // Compare absolute values of two BigInts (ignore signs)
-    // Returns: 1 if |this| > |other|, 0 if equal, -1 if |this| < |other|
-    int compareMagnitude(const BigInt &other) const
+    // Bytes requested from operator new on this thread, ever. A plain
+    // thread_local integer, so the allocator hook below can bump it
+    // without allocating or registering a slot.
+    inline thread_local uint64_t allocatedBytes = 0;
+
+    inline void recordTier(Op op, Tier tier)
     {
-        if (number.size() > other.number.size())
+        localSlot().ops[op].tiers[tier].add(1);
+    }
+
+    // Times one operator call and counts the bytes it allocates (both
+    // inclusive of nested operators), and records the size of the larger
+    // operand in the histogram.
+    class OpScope
+    {
+        OpCounters &counters;
+        uint64_t start;
+        uint64_t startBytes;
+
+    public:
+        OpScope(Op op, size_t lhsDigits, size_t rhsDigits)
+            : counters(localSlot().ops[op]), start(nowNanos()), startBytes(allocatedBytes)
         {
-            return 1;
+            counters.calls.add(1);
+            counters.sizeHistogram[sizeBucket(max(lhsDigits, rhsDigits))].add(1);
         }
-        else if (number.size() < other.number.size())
+        ~OpScope()
         {
-            return -1;
+            counters.nanos.add(nowNanos() - start);
+            counters.bytes.add(allocatedBytes - startBytes);
         }
-        else
+    };
+
+    // Named region emitted as a Chrome trace "complete" event ("ph":"X").
+    // The output loads in chrome://tracing, Perfetto and speedscope, and can
+    // be lined up with `perf record -k CLOCK_MONOTONIC` through the shared
+    // steady clock.
+    class TraceScope
+    {
+        const char *name;
+        uint64_t start;
+
+    public:
+        explicit TraceScope(const char *regionName) : name(regionName)
+        {
+            localSlot(); // register first so the region never predates the trace epoch
+            start = nowNanos();
+        }
+        ~TraceScope()
         {
-            for (int i = 0; i < number.size(); i++)
+            ThreadSlot &slot = localSlot();
+            lock_guard<mutex> guard(slot.traceMutex);
+            if (slot.trace.size() < MAX_TRACE_EVENTS)
             {
-                if (number[i] > other.number[i])
-                    return 1;
-                else if (number[i] < other.number[i])
-                    return -1;
+                slot.trace.push_back({name, start, nowNanos() - start});
             }
-            return 0;
         }
-    }
+    };
 
-    // Default constructor - initialize to zero
-    BigInt()
+    struct OpSnapshot
     {
-        number = "0";
-        isNegative = false;
-    }
+        uint64_t calls = 0;
+        uint64_t nanos = 0;
+        uint64_t bytes = 0;
+        uint64_t sizeHistogram[SIZE_BUCKETS] = {};
+        uint64_t tiers[TIER_COUNT] = {};
+    };
+
+    struct Snapshot
+    {
+        OpSnapshot ops[OP_COUNT];
+        size_t threads = 0;
+    };
 
-    // Constructor from 64-bit integer
-    BigInt(int64_t value)
+    // Sum the counters of every thread that has recorded anything so far
+    inline Snapshot snapshot()
     {
-        if (value > 0)
+        Snapshot snap;
+        Registry &reg = registry();
+        lock_guard<mutex> guard(reg.lock);
+        snap.threads = reg.slots.size();
+        for (const shared_ptr<ThreadSlot> &slot : reg.slots)
         {
-            isNegative = false;
-            number = to_string(value);
+            for (int op = 0; op < OP_COUNT; op++)
+            {
+                const OpCounters &src = slot->ops[op];
+                OpSnapshot &dst = snap.ops[op];
+                dst.calls += src.calls.get();
+                dst.nanos += src.nanos.get();
+                dst.bytes += src.bytes.get();
+                for (int b = 0; b < SIZE_BUCKETS; b++)
+                    dst.sizeHistogram[b] += src.sizeHistogram[b].get();
+                for (int t = 0; t < TIER_COUNT; t++)
+                    dst.tiers[t] += src.tiers[t].get();
+            }
         }
-        else if (value < 0)
+        return snap;
+    }
+
+    // Write a snapshot as JSON; empty histogram buckets and tiers are omitted
+    inline void dumpJSON(ostream &os, const Snapshot &snap)
+    {
+        os << "{\"threads\":" << snap.threads << ",\"ops\":{";
+        for (int op = 0; op < OP_COUNT; op++)
         {
-            isNegative = true;
-            if (value == INT64_MIN) // cause |MIN| - |MAX| = 1 , so I will cause overflow
+            const OpSnapshot &s = snap.ops[op];
+            os << (op ? "," : "") << "\"" << opNames[op] << "\":{\"calls\":" << s.calls
+               << ",\"nanos\":" << s.nanos << ",\"bytes\":" << s.bytes << ",\"digitsHistogram\":{";
+            bool first = true;
+            for (int b = 0; b < SIZE_BUCKETS; b++)
             {
-                number = "9223372036854775808";
+                if (s.sizeHistogram[b])
+                {
+                    os << (first ? "" : ",") << "\"" << (uint64_t(1) << b) << "\":" << s.sizeHistogram[b];
+                    first = false;
+                }
             }
-            else
+            os << "},\"tiers\":{";
+            first = true;
+            for (int t = 0; t < TIER_COUNT; t++)
             {
-                number = to_string(-value);
+                if (s.tiers[t])
+                {
+                    os << (first ? "" : ",") << "\"" << tierNames[t] << "\":" << s.tiers[t];
+                    first = false;
+                }
             }
+            os << "}}";
         }
-        else
-        {
-            isNegative = false;
-            number = "0";
-        }
+        os << "}}" << endl;
+    }
 
-        removeLeadingZeros();
+    inline void dumpJSON(ostream &os)
+    {
+        dumpJSON(os, snapshot());
     }
 
-    // Constructor from string representation
-    BigInt(const string &str)
+    // Chrome trace timestamps are microseconds; keep nanosecond resolution
+    inline void writeMicros(ostream &os, uint64_t nanos)
     {
-        if (str.empty())
-        {
-            throw invalid_argument("Invalid empty string for BigInt");
-        }
-        string s = str;
-        if (s[0] == '-')
-        {
-            isNegative = true;
-            s.erase(0, 1);
-        }
-        else if (s[0] == '+')
-        {
-            isNegative = false;
-            s.erase(0, 1);
-        }
-        else
-        {
-            isNegative = false;
-        }
-        if (s.empty())
-        {
-            throw invalid_argument("Invalid input string: " + str + " (only sign character)");
-        }
+        uint64_t frac = nanos % 1000;
+        os << nanos / 1000 << '.' << char('0' + frac / 100) << char('0' + frac / 10 % 10) << char('0' + frac % 10);
+    }
 
-        for (char c : s)
+    // Write all recorded trace regions in Chrome trace event format
+    inline void dumpChromeTrace(ostream &os)
+    {
+        Registry &reg = registry();
+        lock_guard<mutex> guard(reg.lock);
+        os << "{\"traceEvents\":[";
+        bool first = true;
+        for (const shared_ptr<ThreadSlot> &slot : reg.slots)
         {
-            if (c < '0' || c > '9')
+            lock_guard<mutex> traceGuard(slot->traceMutex);
+            for (const TraceEvent &ev : slot->trace)
             {
-                throw invalid_argument("Invalid input string: " + str + " (contains non-digit characters)");
+                os << (first ? "" : ",") << "{\"name\":\"" << ev.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                   << slot->threadId << ",\"ts\":";
+                writeMicros(os, ev.startNanos - reg.epochNanos);
+                os << ",\"dur\":";
+                writeMicros(os, ev.durationNanos);
+                os << "}";
+                first = false;
             }
         }
+        os << "],\"displayTimeUnit\":\"ns\"}" << endl;
+    }
 
-        number = s;
-        removeLeadingZeros();
-        if (number == "0")
+    // Clear every counter and trace buffer (slots stay registered)
+    inline void reset()
+    {
+        Registry &reg = registry();
+        lock_guard<mutex> guard(reg.lock);
+        for (const shared_ptr<ThreadSlot> &slot : reg.slots)
         {
-            isNegative = false;
+            for (OpCounters &c : slot->ops)
+            {
+                c.calls.value = 0;
+                c.nanos.value = 0;
+                c.bytes.value = 0;
+                for (Counter &b : c.sizeHistogram)
+                    b.value = 0;
+                for (Counter &t : c.tiers)
+                    t.value = 0;
+            }
+            lock_guard<mutex> traceGuard(slot->traceMutex);
+            slot->trace.clear();
         }
     }
+}
 
-    // Copy constructor
-    BigInt(const BigInt &other)
-    {
-        number = other.number;
-        isNegative = other.isNegative;
-    }
+// The instrumented build replaces the global operator new so OpScope
+// sees every byte an operator allocates, from digit buffers to limb
+// vectors and temporaries inside the standard library. The library's
+// own operator delete releases malloc'd memory (libstdc++, libc++ and
+// the MSVC runtime all free()), so it is left alone. Kept out of line:
+// once GCC inlines the malloc() it reports every new/delete pair as
+// mismatched.
+[[gnu::noinline]] void *operator new(size_t size)
+{
+    titan_stats::allocatedBytes += size;
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
 
-    // Destructor
-    ~BigInt()
+#define TITAN_CONCAT_INNER(a, b) a##b
+#define TITAN_CONCAT(a, b) TITAN_CONCAT_INNER(a, b)
+#define TITAN_OP_SCOPE(op, lhsDigits, rhsDigits) \
+    titan_stats::OpScope TITAN_CONCAT(titanOpScope_, __LINE__)(titan_stats::op, (lhsDigits), (rhsDigits))
+#define TITAN_OP_TIER(op, tier) titan_stats::recordTier(titan_stats::op, titan_stats::tier)
+#define TITAN_TRACE_SCOPE(name) titan_stats::TraceScope TITAN_CONCAT(titanTraceScope_, __LINE__)(name)
+#else
+#define TITAN_OP_SCOPE(op, lhsDigits, rhsDigits) ((void)0)
+#define TITAN_OP_TIER(op, tier) ((void)0)
+#define TITAN_TRACE_SCOPE(name) ((void)0)
+#endif
+
+// ==================== MULTIPLICATION KERNELS ====================
+// The operators keep the decimal string as the stored form, but the
+// multiplication kernels work on base 10^9 limbs (little-endian) so each
+// inner step handles nine digits at once.
+
+typedef vector<uint32_t> Limbs;
+
+const uint32_t LIMB_BASE = 1000000000;
+const int LIMB_DIGITS = 9;
+// Operands shorter than this (in limbs) use schoolbook multiplication;
+// tunable (see TUNING)
+size_t KARATSUBA_THRESHOLD = 32;
+
+// Decimal digit string (most significant first) to limbs
+static Limbs toLimbs(const string &digits)
+{
+    Limbs limbs;
+    limbs.reserve(digits.size() / LIMB_DIGITS + 1);
+    for (size_t end = digits.size(); end > 0;)
     {
-        // no destructor nedeed
+        size_t begin = end > (size_t)LIMB_DIGITS ? end - LIMB_DIGITS : 0;
+        uint32_t limb = 0;
+        for (size_t i = begin; i < end; i++)
+            limb = limb * 10 + (digits[i] - '0');
+        limbs.push_back(limb);
+        end = begin;
     }
+    return limbs;
+}
 
-    // Assignment operator
-    BigInt &operator=(const BigInt &other)
+// Limbs back to a decimal digit string without leading zeros
+static string fromLimbs(const Limbs &limbs)
+{
+    size_t top = limbs.size();
+    while (top > 1 && limbs[top - 1] == 0)
+        --top;
+    if (top == 0)
+        return "0";
+    string digits = to_string(limbs[top - 1]);
+    digits.reserve(digits.size() + (top - 1) * LIMB_DIGITS);
+    char buffer[LIMB_DIGITS];
+    for (size_t i = top - 1; i-- > 0;)
     {
-        if (this != &other)
+        uint32_t limb = limbs[i];
+        for (int d = LIMB_DIGITS - 1; d >= 0; d--)
         {
-            number = other.number;
-            isNegative = other.isNegative;
+            buffer[d] = '0' + limb % 10;
+            limb /= 10;
         }
-        return *this;
+        digits.append(buffer, LIMB_DIGITS);
     }
+    return digits;
+}
 
-    // Unary negation operator (-x)
-    BigInt operator-() const
+static void trimLimbs(Limbs &a)
+{
+    while (!a.empty() && a.back() == 0)
+        a.pop_back();
+}
+
+// out[0 .. n+m) = a * b; out must be zeroed by the caller
+static void mulSchoolbook(const uint32_t *a, size_t n, const uint32_t *b, size_t m, uint32_t *out)
+{
+    for (size_t i = 0; i < n; i++)
     {
-        BigInt result(*this);
-        if (result.number != "0")
+        uint64_t carry = 0;
+        uint64_t ai = a[i];
+        for (size_t j = 0; j < m; j++)
         {
-            result.isNegative = !isNegative;
+            uint64_t t = out[i + j] + ai * b[j] + carry;
+            out[i + j] = (uint32_t)(t % LIMB_BASE);
+            carry = t / LIMB_BASE;
         }
-        else
+        out[i + m] = (uint32_t)carry;
+    }
+}
+
+// out[0 .. 2n) = a * a; out must be zeroed by the caller. Each cross
+// product a[i] * a[j] (i < j) is formed once and the sum doubled, then
+// the squares a[i]^2 are added on the diagonal: about half the limb
+// products of mulSchoolbook(a, n, a, n, out).
+static void sqrSchoolbook(const uint32_t *a, size_t n, uint32_t *out)
+{
+    for (size_t i = 0; i + 1 < n; i++)
+    {
+        uint64_t carry = 0;
+        uint64_t ai = a[i];
+        for (size_t j = i + 1; j < n; j++)
         {
-            result.isNegative = false;
+            uint64_t t = out[i + j] + ai * a[j] + carry;
+            out[i + j] = (uint32_t)(t % LIMB_BASE);
+            carry = t / LIMB_BASE;
         }
-        return result;
+        out[i + n] = (uint32_t)carry;
     }
-
-    // Unary plus operator (+x)
-    BigInt operator+() const
+    uint64_t carry = 0;
+    for (size_t k = 0; k < 2 * n; k++)
     {
-        return *this; // return the copy
+        uint64_t t = 2 * (uint64_t)out[k] + carry;
+        if (k % 2 == 0)
+            t += (uint64_t)a[k / 2] * a[k / 2];
+        out[k] = (uint32_t)(t % LIMB_BASE);
+        carry = t / LIMB_BASE;
     }
+}
 
-    // Addition assignment operator (x += y)
-    BigInt &operator+=(const BigInt &other)
+// a += b << (offset limbs); a must be large enough to hold the result
+static void addLimbsAt(Limbs &a, const Limbs &b, size_t offset)
+{
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i < b.size() || carry; i++)
     {
-        BigInt temp = *this;
-        *this = temp + other;
-        return *this;
+        uint32_t sum = a[offset + i] + carry + (i < b.size() ? b[i] : 0);
+        carry = sum >= LIMB_BASE;
+        a[offset + i] = carry ? sum - LIMB_BASE : sum;
     }
+}
 
-    // Subtraction assignment operator (x -= y)
-    BigInt &operator-=(const BigInt &other)
+// a -= b, requires a >= b
+static void subLimbs(Limbs &a, const Limbs &b)
+{
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < b.size() || borrow; i++)
     {
-        BigInt temp = *this;
-        *this = temp - other;
-        return *this;
+        uint32_t sub = (i < b.size() ? b[i] : 0) + borrow;
+        borrow = a[i] < sub;
+        a[i] = borrow ? a[i] + LIMB_BASE - sub : a[i] - sub;
     }
+}
 
-    // Multiplication assignment operator (x *= y)
-    BigInt &operator*=(const BigInt &other)
+static Limbs addLimbs(const Limbs &a, const Limbs &b)
+{
+    Limbs sum(max(a.size(), b.size()) + 1, 0);
+    addLimbsAt(sum, a, 0);
+    addLimbsAt(sum, b, 0);
+    trimLimbs(sum);
+    return sum;
+}
+
+// Product of two limb vectors: schoolbook below KARATSUBA_THRESHOLD,
+// Karatsuba above it. Very unbalanced operands are cut into slices the
+// size of the shorter one so that every recursive product stays balanced.
+static Limbs mulLimbs(const Limbs &a, const Limbs &b)
+{
+    if (a.size() < b.size())
+        return mulLimbs(b, a);
+    size_t n = a.size(), m = b.size();
+    if (m == 0)
+        return Limbs();
+
+    Limbs result(n + m, 0);
+    if (m < KARATSUBA_THRESHOLD)
+    {
+        mulSchoolbook(a.data(), n, b.data(), m, result.data());
+    }
+    else if (2 * m <= n)
     {
-        int n = number.length(), m = other.number.length();
-        if (n == 0 || m == 0)
+        for (size_t offset = 0; offset < n; offset += m)
         {
-            number = "0";
-            isNegative = false;
-            return *this;
+            Limbs slice(a.begin() + offset, a.begin() + min(offset + m, n));
+            trimLimbs(slice);
+            addLimbsAt(result, mulLimbs(slice, b), offset);
         }
+    }
+    else
+    {
+        // a = a1*B^h + a0, b = b1*B^h + b0 with h = ceil(n/2) < m
+        size_t h = (n + 1) / 2;
+        Limbs a0(a.begin(), a.begin() + h), a1(a.begin() + h, a.end());
+        Limbs b0(b.begin(), b.begin() + h), b1(b.begin() + h, b.end());
+        trimLimbs(a0);
+        trimLimbs(b0);
+
+        Limbs z0 = mulLimbs(a0, b0);
+        Limbs z2 = mulLimbs(a1, b1);
+        Limbs z1 = mulLimbs(addLimbs(a0, a1), addLimbs(b0, b1));
+        subLimbs(z1, z0);
+        subLimbs(z1, z2);
+        trimLimbs(z1);
+
+        addLimbsAt(result, z0, 0);
+        addLimbsAt(result, z1, h);
+        addLimbsAt(result, z2, 2 * h);
+    }
+    trimLimbs(result);
+    return result;
+}
 
-        vector<int> result(n + m, 0);
+// a * a: schoolbook squaring below KARATSUBA_THRESHOLD, and above it
+// Karatsuba on the shared halves, where all three products are squares
+// (a0^2, a1^2 and (a0 + a1)^2) and only one half split is needed
+static Limbs sqrLimbs(const Limbs &a)
+{
+    size_t n = a.size();
+    if (n == 0)
+        return Limbs();
+
+    Limbs result(2 * n, 0);
+    if (n < KARATSUBA_THRESHOLD)
+    {
+        sqrSchoolbook(a.data(), n, result.data());
+    }
+    else
+    {
+        size_t h = (n + 1) / 2;
+        Limbs a0(a.begin(), a.begin() + h), a1(a.begin() + h, a.end());
+        trimLimbs(a0);
+
+        Limbs z0 = sqrLimbs(a0);
+        Limbs z2 = sqrLimbs(a1);
+        Limbs z1 = sqrLimbs(addLimbs(a0, a1));
+        subLimbs(z1, z0);
+        subLimbs(z1, z2);
+        trimLimbs(z1);
+
+        addLimbsAt(result, z0, 0);
+        addLimbsAt(result, z1, h);
+        addLimbsAt(result, z2, 2 * h);
+    }
+    trimLimbs(result);
+    return result;
+}
 
-        for (int i = n - 1; i >= 0; i--)
+// ==================== DIGIT STORAGE ====================
+// Reference-counted, copy-on-write holder for the digit string. Copying a
+// BigInt only bumps an atomic count, so large constants can be passed
+// around and stored in containers in O(1); the first mutation of a shared
+// buffer clones it. Sharing across threads is safe as long as each BigInt
+// object is itself used by one thread at a time (the shared_ptr rule).
+// Build with -DTITANINT_DEEP_COPY to copy eagerly instead.
+// The block also caches the hash of its digits, so copies share one hash
+// computation; any mutation resets it.
+// Live storage objects, buffers and buffer bytes are counted process-wide
+// (see memoryStats). A buffer's bytes are re-counted whenever its owner
+// edits or frees it, so growth through edit() shows up at the next access.
+
+static atomic<size_t> liveDigitObjects(0), liveDigitBuffers(0), liveDigitBytes(0);
+
+class DigitStorage
+{
+    struct Block
+    {
+        // 32-bit count next to the flag keeps the header at 24 bytes
+        atomic<uint32_t> refs;
+        atomic<bool> interned;  // canonical copy owned by the intern table
+        atomic<uint64_t> hash;  // 0 = not computed yet
+        size_t accounted;       // bytes currently added to liveDigitBytes
+        string digits;
+
+        explicit Block(const string &d) : refs(1), interned(false), hash(0), accounted(0), digits(d)
         {
-            for (int j = m - 1; j >= 0; j--)
-            {
-                int mul = (number[i] - '0') * (other.number[j] - '0');
-                int sum = result[i + j + 1] + mul;
+            accounted = footprint();
+            liveDigitBuffers.fetch_add(1, memory_order_relaxed);
+            liveDigitBytes.fetch_add(accounted, memory_order_relaxed);
+        }
 
-                result[i + j + 1] = sum % 10;
-                result[i + j] += sum / 10;
-            }
+        ~Block()
+        {
+            liveDigitBuffers.fetch_sub(1, memory_order_relaxed);
+            liveDigitBytes.fetch_sub(accounted, memory_order_relaxed);
+        }
+
+        // The block plus the string's heap buffer (none while the digits
+        // fit in the string's inline storage)
+        size_t footprint() const
+        {
+            const char *data = digits.data();
+            bool inline_ = data >= (const char *)&digits && data < (const char *)(&digits + 1);
+            return sizeof(Block) + (inline_ ? 0 : digits.capacity() + 1);
         }
 
-        string str = "";
-        for (int num : result)
+        // Brings liveDigitBytes up to date; only the sole owner may call it
+        void account()
         {
-            if (!(str.empty() && num == 0))
+            size_t now = footprint();
+            if (now != accounted)
             {
-                str += to_string(num);
+                liveDigitBytes.fetch_add(now - accounted, memory_order_relaxed); // wraps for a decrease
+                accounted = now;
             }
         }
+    };
+    Block *block;
 
-        number = str.empty() ? "0" : str;
-        isNegative = (isNegative != other.isNegative) && (number != "0");
-        removeLeadingZeros();
-        return *this;
-    }
+    // A buffer shared by this many holders is copied instead of shared
+    // again, which keeps the 32-bit count far from overflowing
+    static const uint32_t MAX_SHARED_REFS = 1u << 31;
 
-    // Division assignment operator (x /= y)
-    BigInt &operator/=(const BigInt &other)
+    // b with one more holder, or a private copy once b is shared too widely
+    static Block *acquire(Block *b)
     {
-        *this = *this / other;
-        return *this;
+        if (b->refs.load(memory_order_relaxed) >= MAX_SHARED_REFS)
+        {
+            return new Block(b->digits);
+        }
+        b->refs.fetch_add(1, memory_order_relaxed);
+        return b;
     }
 
-    // Modulus assignment operator (x %= y)
-    BigInt &operator%=(const BigInt &other)
+    // Shared "0" buffer for default-constructed values, never freed
+    static Block *zeroBlock()
     {
-        *this = *this % other;
-        return *this;
+        static Block *zero = new Block("0");
+        return acquire(zero);
     }
 
-    // Pre-increment operator (++x)
-    BigInt &operator++()
+    void release()
     {
-        *this += BigInt(1);
-        return *this;
+        if (block->refs.fetch_sub(1, memory_order_acq_rel) == 1)
+        {
+            delete block; // ~Block subtracts what was accounted
+        }
     }
 
-    // Post-increment operator (x++)
-    BigInt operator++(int)
+public:
+    DigitStorage() : block(zeroBlock())
     {
-        BigInt temp = *this;
-        *this += BigInt(1);
-        return temp;
+        liveDigitObjects.fetch_add(1, memory_order_relaxed);
     }
 
-    // Pre-decrement operator (--x)
-    BigInt &operator--()
+    DigitStorage(const DigitStorage &other)
     {
-        // TODO: Implement this operator
-        *this -= BigInt(1);
-        return *this;
+        liveDigitObjects.fetch_add(1, memory_order_relaxed);
+#ifdef TITANINT_DEEP_COPY
+        block = new Block(other.block->digits);
+#else
+        block = acquire(other.block);
+#endif
     }
 
-    // Post-decrement operator (x--)
-    BigInt operator--(int)
+    ~DigitStorage()
     {
-        BigInt temp(*this);
-        *this -= BigInt(1);
-        return temp;
+        liveDigitObjects.fetch_sub(1, memory_order_relaxed);
+        release();
     }
 
-    // Convert BigInt to string representation
-    string toString() const
+    DigitStorage &operator=(const DigitStorage &other)
     {
-        if (isNegative && number != "0")
+        if (block != other.block)
         {
-            return "-" + number; // return the number with the sign if negative
+#ifdef TITANINT_DEEP_COPY
+            edit() = other.block->digits;
+#else
+            Block *shared = acquire(other.block);
+            release();
+            block = shared;
+#endif
         }
-
-        return number; // return the number if zero or positive
+        return *this;
     }
 
-    // Output stream operator (for printing)
-    friend ostream &operator<<(ostream &os, const BigInt &num)
+    // Replace the contents; a shared buffer is dropped rather than cloned
+    DigitStorage &operator=(const string &digits)
     {
-        os << num.toString();
-        return os;
+        return assign(digits.data(), digits.size());
     }
 
-    // Input stream operator (for reading from input)
-    friend istream &operator>>(istream &is, BigInt &num)
+    // Same from a character range; an unshared buffer keeps its capacity
+    DigitStorage &assign(const char *digits, size_t size)
     {
-
-        string str;
-        is >> str;
-        num = BigInt(str);
-        return is;
+        if (isShared())
+        {
+            release();
+            block = new Block(string(digits, size));
+        }
+        else
+        {
+            block->digits.assign(digits, size);
+            block->hash.store(0, memory_order_relaxed);
+            block->interned.store(false, memory_order_release);
+            block->account();
+        }
+        return *this;
     }
 
-    // Friend declarations for comparison operators
-    friend bool operator==(const BigInt &lhs, const BigInt &rhs);
-    friend bool operator<(const BigInt &lhs, const BigInt &rhs);
-
-    // using getters for decleraition number and isNegative in binary opertators
-    string getNumber() const
+    // Read-only view, never copies
+    const string &str() const
     {
-        return number;
+        return block->digits;
     }
-    bool getIsNegative() const
+
+    // Writable view; clones the buffer first if anyone else holds it.
+    // An interned block normally has the table as a second holder and is
+    // cloned; one edited in place (the table cleared, or a private copy
+    // under TITANINT_DEEP_COPY) stops being canonical.
+    string &edit()
+    {
+        if (isShared())
+        {
+            Block *copy = new Block(block->digits);
+            release();
+            block = copy;
+        }
+        else
+        {
+            block->account(); // for changes made through the last edit()
+            block->interned.store(false, memory_order_release);
+        }
+        block->hash.store(0, memory_order_relaxed);
+        return block->digits;
+    }
+
+    // Room for `digits` digits without reallocating (clones a shared buffer)
+    void reserve(size_t digits)
+    {
+        edit().reserve(digits);
+        block->account();
+    }
+
+    // Drops unused capacity; a shared buffer is left alone
+    void shrinkToFit()
+    {
+        if (!isShared())
+        {
+            block->digits.shrink_to_fit();
+            block->account();
+        }
+    }
+
+    // Bytes of the buffer this value points at, counted in full even when shared
+    size_t bufferBytes() const
+    {
+        return block->footprint();
+    }
+
+    // 64-bit hash of the digits, computed once per buffer
+    uint64_t hash() const
+    {
+        uint64_t h = block->hash.load(memory_order_relaxed);
+        if (h == 0)
+        {
+            h = hashDigits(block->digits);
+            block->hash.store(h, memory_order_relaxed);
+        }
+        return h;
+    }
+
+    // Cached hash if already computed, otherwise 0
+    uint64_t cachedHash() const
+    {
+        return block->hash.load(memory_order_relaxed);
+    }
+
+    // Word-at-a-time hash: 8 digits per multiply, splitmix64 finalizer.
+    // Never returns 0, which marks an empty cache slot.
+    static uint64_t hashDigits(const string &digits)
+    {
+        uint64_t h = 0x9e3779b97f4a7c15ULL ^ digits.size();
+        size_t i = 0;
+        for (; i + 8 <= digits.size(); i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, digits.data() + i, 8);
+            h = (h ^ word) * 0xff51afd7ed558ccdULL;
+            h ^= h >> 32;
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, digits.data() + i, digits.size() - i);
+        h = (h ^ tail) * 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h ? h : 1;
+    }
+
+    bool sameBuffer(const DigitStorage &other) const
+    {
+        return block == other.block;
+    }
+
+    bool isInterned() const
+    {
+        return block->interned.load(memory_order_acquire);
+    }
+
+    void setInterned(bool value) const
+    {
+        block->interned.store(value, memory_order_release);
+    }
+
+    bool isShared() const
+    {
+        return block->refs.load(memory_order_acquire) != 1;
+    }
+
+    // Number of BigInt values currently sharing this buffer
+    size_t useCount() const
+    {
+        return block->refs.load(memory_order_relaxed);
+    }
+};
+
+// Process-wide digit storage footprint, for capacity planning
+struct MemoryStats
+{
+    size_t liveObjects; // BigInt values (each holds one DigitStorage)
+    size_t liveBuffers; // distinct digit buffers, shared or not
+    size_t liveBytes;   // buffer blocks plus their heap digits
+};
+
+MemoryStats memoryStats()
+{
+    return {liveDigitObjects.load(memory_order_relaxed), liveDigitBuffers.load(memory_order_relaxed),
+            liveDigitBytes.load(memory_order_relaxed)};
+}
+
+class BigInt;
+BigInt operator+(BigInt lhs, const BigInt &rhs);
+BigInt operator-(BigInt lhs, const BigInt &rhs);
+BigInt operator*(BigInt lhs, const BigInt &rhs);
+BigInt operator/(BigInt lhs, const BigInt &rhs);
+BigInt operator%(BigInt lhs, const BigInt &rhs);
+static pair<BigInt, BigInt> divmodNewton(const BigInt &a, const BigInt &d);
+
+class BigInt
+{
+    DigitStorage number; // Stores the number as a string (shared copy-on-write)
+    bool isNegative; // True if number is negative
+
+public:
+    // Moved function (removeLeadingZeros,compareMagnitude) to public for declaration and external access
+    // Remove unnecessary leading zeros from the number string
+    void removeLeadingZeros()
+    {
+        const string &digits = number.str();
+        size_t i = 0;
+        while (i < digits.length() && digits[i] == '0')
+        {
+            ++i;
+        }
+        if (i == 0)
+        {
+            return; // already normalized; leave a shared buffer shared
+        }
+        if (i == digits.length())
+        {
+            number = "0";
+            isNegative = false;
+            return;
+        }
+        number.edit().erase(0, i);
+    }
+
+    // Compare absolute values of two BigInts (ignore signs)
+    // Returns: 1 if |this| > |other|, 0 if equal, -1 if |this| < |other|
+    // Lengths decide first; equal lengths take one memcmp over the digits.
+    int compareMagnitude(const BigInt &other) const
+    {
+        const string &a = number.str(), &b = other.number.str();
+        TITAN_OP_SCOPE(OP_COMPARE, a.size(), b.size());
+        if (a.size() != b.size())
+        {
+            return a.size() > b.size() ? 1 : -1;
+        }
+        if (number.sameBuffer(other.number))
+        {
+            return 0;
+        }
+        int order = memcmp(a.data(), b.data(), a.size());
+        return (order > 0) - (order < 0);
+    }
+
+    // Three-way comparison: -1, 0 or 1 as this <, ==, > other.
+    // One scan and no copies; every relational operator is built on it.
+    int compare(const BigInt &other) const
+    {
+        if (isNegative != other.isNegative)
+        {
+            return isNegative ? -1 : 1;
+        }
+        int magnitude = compareMagnitude(other);
+        return isNegative ? -magnitude : magnitude;
+    }
+
+    // Order-preserving 64-bit prefix key for radix and parallel sorts:
+    // sortKey(a) < sortKey(b) implies a < b, and a < b implies
+    // sortKey(a) <= sortKey(b); equal keys are settled by compare().
+    // Layout: sign bit, 24-bit digit count, then the first 11 digits;
+    // negative values have the low 63 bits inverted. Once the count
+    // saturates the prefix is left out, since values of different lengths
+    // would otherwise be ordered by their leading digits.
+    uint64_t sortKey() const
+    {
+        const uint64_t maxLength = (1u << 24) - 1;
+        const string &digits = number.str();
+        uint64_t length = min<uint64_t>(digits.size(), maxLength);
+        uint64_t prefix = 0;
+        for (size_t i = 0; i < 11 && length < maxLength; i++)
+        {
+            prefix = prefix * 10 + (i < digits.size() ? digits[i] - '0' : 0);
+        }
+        uint64_t key = length << 39 | prefix; // 10^11 < 2^39
+        return isNegative ? ~key & ~(1ULL << 63) : key | 1ULL << 63;
+    }
+
+    // Default constructor - initialize to zero
+    BigInt()
+    {
+        isNegative = false;
+    }
+
+    // Constructor from 64-bit integer
+    BigInt(int64_t value)
+    {
+        if (value > 0)
+        {
+            isNegative = false;
+            number = to_string(value);
+        }
+        else if (value < 0)
+        {
+            isNegative = true;
+            if (value == INT64_MIN) // cause |MIN| - |MAX| = 1 , so I will cause overflow
+            {
+                number = "9223372036854775808";
+            }
+            else
+            {
+                number = to_string(-value);
+            }
+        }
+        else
+        {
+            isNegative = false;
+            number = "0";
+        }
+
+        removeLeadingZeros();
+    }
+
+    // Constructor from string representation
+    BigInt(const string &str)
+    {
+        isNegative = false;
+        assign(str);
+    }
+
+    // Parses str into this value, reusing the digit buffer when it is not
+    // shared (so a value parsed over and over stops allocating). Throws
+    // invalid_argument like the string constructor and is then unchanged.
+    BigInt &assign(const string &str)
+    {
+        if (str.empty())
+        {
+            throw invalid_argument("Invalid empty string for BigInt");
+        }
+        size_t begin = str[0] == '-' || str[0] == '+' ? 1 : 0;
+        if (begin == str.size())
+        {
+            throw invalid_argument("Invalid input string: " + str + " (only sign character)");
+        }
+        for (size_t i = begin; i < str.size(); i++)
+        {
+            if (str[i] < '0' || str[i] > '9')
+            {
+                throw invalid_argument("Invalid input string: " + str + " (contains non-digit characters)");
+            }
+        }
+
+        size_t first = min(str.find_first_not_of('0', begin), str.size() - 1); // keep one zero
+        number.assign(str.data() + first, str.size() - first);
+        isNegative = str[0] == '-' && !isZero();
+        return *this;
+    }
+
+    // Copy constructor
+    BigInt(const BigInt &other) : number(other.number), isNegative(other.isNegative)
+    {
+        // O(1): the digit buffer is shared until one side is modified
+    }
+
+    // Destructor
+    ~BigInt()
+    {
+        // no destructor nedeed
+    }
+
+    // Assignment operator
+    BigInt &operator=(const BigInt &other)
+    {
+        if (this != &other)
+        {
+            number = other.number;
+            isNegative = other.isNegative;
+        }
+        return *this;
+    }
+
+    // Unary negation operator (-x)
+    BigInt operator-() const
+    {
+        BigInt result(*this);
+        if (!result.isZero())
+        {
+            result.isNegative = !isNegative;
+        }
+        else
+        {
+            result.isNegative = false;
+        }
+        return result;
+    }
+
+    // Unary plus operator (+x)
+    BigInt operator+() const
+    {
+        return *this; // return the copy
+    }
+
+    // Addition assignment operator (x += y)
+    // Same signs add in place: digits are summed right to left into this
+    // buffer, which only grows when other is longer or a carry leaves it
+    BigInt &operator+=(const BigInt &other)
+    {
+        if (isNegative != other.isNegative && !isZero() && !other.isZero())
+        {
+            *this = *this + other;
+            return *this;
+        }
+        if (other.isZero())
+        {
+            return *this;
+        }
+        if (&other == this)
+        {
+            BigInt copy = other;
+            return *this += copy;
+        }
+        TITAN_OP_SCOPE(OP_ADD, digitCount(), other.digitCount());
+        TITAN_OP_TIER(OP_ADD, TIER_SCHOOLBOOK);
+        isNegative = other.isNegative; // this may have been zero
+        const string &b = other.number.str();
+        string &a = number.edit();
+        if (a.size() < b.size())
+        {
+            a.insert(0, b.size() - a.size(), '0');
+        }
+        size_t n = a.size(), m = b.size();
+        int carry = 0;
+        for (size_t i = 0; i < n && (i < m || carry); i++)
+        {
+            int sum = (a[n - 1 - i] - '0') + (i < m ? b[m - 1 - i] - '0' : 0) + carry;
+            carry = sum >= 10;
+            a[n - 1 - i] = (char)('0' + sum - 10 * carry);
+        }
+        if (carry)
+        {
+            a.insert(0, 1, '1');
+        }
+        return *this;
+    }
+
+    // Subtraction assignment operator (x -= y)
+    BigInt &operator-=(const BigInt &other)
+    {
+        BigInt temp = *this;
+        *this = temp - other;
+        return *this;
+    }
+
+    // Multiplication assignment operator (x *= y)
+    BigInt &operator*=(const BigInt &other)
+    {
+        *this = *this * other;
+        return *this;
+    }
+
+    // Division assignment operator (x /= y)
+    BigInt &operator/=(const BigInt &other)
+    {
+        *this = *this / other;
+        return *this;
+    }
+
+    // Modulus assignment operator (x %= y)
+    BigInt &operator%=(const BigInt &other)
+    {
+        *this = *this % other;
+        return *this;
+    }
+
+    // ---- Single-limb (native integer) arithmetic ----
+    // Each of these is one in-place pass over the digit string. The operator
+    // templates accept any integer type, so `x * 10` binds here instead of
+    // converting 10 through BigInt(int64_t), and int, long, int64_t and
+    // uint64_t operands never become ambiguous between overloads.
+
+    // Magnitude of a native integer as uint64_t (safe for INT64_MIN)
+    template <typename T>
+    static uint64_t nativeMagnitude(T value)
+    {
+        if (is_signed<T>::value && value < T(0))
+        {
+            return uint64_t(-(value + T(1))) + 1;
+        }
+        return uint64_t(value);
+    }
+
+    template <typename T>
+    static bool nativeIsNegative(T value)
+    {
+        return is_signed<T>::value && value < T(0);
+    }
+
+    // Stores the magnitude in out if it fits in uint64_t
+    bool magnitudeToUint64(uint64_t &out) const
+    {
+        const string &digits = number.str();
+        if (digits.size() > 20)
+        {
+            return false;
+        }
+        uint64_t value = 0;
+        for (char c : digits)
+        {
+            uint64_t digit = c - '0';
+            if (value > (UINT64_MAX - digit) / 10)
+            {
+                return false;
+            }
+            value = value * 10 + digit;
+        }
+        out = value;
+        return true;
+    }
+
+    // this += (negative ? -magnitude : magnitude)
+    void addSmall(uint64_t magnitude, bool negative)
+    {
+        TITAN_OP_SCOPE(OP_ADD, digitCount(), 0);
+        TITAN_OP_TIER(OP_ADD, TIER_SCALAR);
+        if (magnitude == 0)
+        {
+            return;
+        }
+        if (isZero())
+        {
+            number = to_string(magnitude);
+            isNegative = negative;
+            return;
+        }
+        if (negative == isNegative)
+        {
+            // Same sign: add the magnitude with carry, no overflow since the
+            // carry is split into its low digit and the rest before adding
+            string &digits = number.edit();
+            uint64_t carry = magnitude;
+            for (size_t i = digits.size(); i-- > 0 && carry;)
+            {
+                uint64_t t = (digits[i] - '0') + carry % 10;
+                carry = carry / 10 + t / 10;
+                digits[i] = '0' + t % 10;
+            }
+            if (carry)
+            {
+                digits.insert(0, to_string(carry));
+            }
+            return;
+        }
+        uint64_t small;
+        if (magnitudeToUint64(small) && small < magnitude)
+        {
+            // |this| < magnitude: the result fits and takes the scalar's sign
+            number = to_string(magnitude - small);
+            isNegative = negative;
+            return;
+        }
+        string &digits = number.edit();
+        uint64_t borrow = magnitude;
+        for (size_t i = digits.size(); i-- > 0 && borrow;)
+        {
+            int d = (digits[i] - '0') - int(borrow % 10);
+            borrow /= 10;
+            if (d < 0)
+            {
+                d += 10;
+                borrow++;
+            }
+            digits[i] = '0' + d;
+        }
+        removeLeadingZeros();
+    }
+
+    // this *= multiplier (magnitude only; the caller fixes the sign)
+    void mulSmall(uint64_t multiplier)
+    {
+        TITAN_OP_SCOPE(OP_MUL, digitCount(), 0);
+        TITAN_OP_TIER(OP_MUL, TIER_SCALAR);
+        if (multiplier == 0 || isZero())
+        {
+            number = "0";
+            isNegative = false;
+            return;
+        }
+        if (multiplier > UINT64_MAX / 10)
+        {
+            // digit * multiplier + carry could overflow; use the general kernel
+            *this = *this * BigInt(to_string(multiplier));
+            return;
+        }
+        string &digits = number.edit();
+        uint64_t carry = 0;
+        for (size_t i = digits.size(); i-- > 0;)
+        {
+            uint64_t t = (digits[i] - '0') * multiplier + carry;
+            digits[i] = '0' + t % 10;
+            carry = t / 10;
+        }
+        if (carry)
+        {
+            digits.insert(0, to_string(carry));
+        }
+    }
+
+    // |this| mod divisor without modifying this.
+    // Requires 0 < divisor <= UINT64_MAX / 10 so remainder * 10 + 9 fits.
+    uint64_t remainderSmall(uint64_t divisor) const
+    {
+        uint64_t remainder = 0;
+        for (char c : number.str())
+        {
+            remainder = (remainder * 10 + (c - '0')) % divisor;
+        }
+        return remainder;
+    }
+
+    // |this| /= divisor in place, returns |this| mod divisor.
+    // Requires 0 < divisor <= UINT64_MAX / 10 so remainder * 10 + 9 fits.
+    uint64_t divideMagnitudeSmall(uint64_t divisor)
+    {
+        TITAN_OP_SCOPE(OP_DIV, digitCount(), 0);
+        TITAN_OP_TIER(OP_DIV, TIER_SCALAR);
+        uint64_t remainder = 0;
+        for (char &c : number.edit())
+        {
+            uint64_t cur = remainder * 10 + (c - '0');
+            c = '0' + cur / divisor;
+            remainder = cur % divisor;
+        }
+        removeLeadingZeros();
+        return remainder;
+    }
+
+    // Divide in place by a native integer and return the remainder.
+    // Truncates toward zero like operator/, so the remainder takes the sign
+    // of the dividend, matching operator%.
+    int64_t divmodSmall(int64_t divisor)
+    {
+        if (divisor == 0)
+        {
+            throw runtime_error("Division by zero");
+        }
+        if (nativeMagnitude(divisor) > UINT64_MAX / 10)
+        {
+            BigInt quotient = *this / BigInt(divisor);
+            int64_t remainder = stoll((*this - quotient * BigInt(divisor)).toString());
+            *this = quotient;
+            return remainder;
+        }
+        bool dividendNegative = isNegative;
+        uint64_t remainder = divideMagnitudeSmall(nativeMagnitude(divisor));
+        isNegative = !isZero() && (dividendNegative != (divisor < 0));
+        return dividendNegative ? -int64_t(remainder) : int64_t(remainder);
+    }
+
+    template <typename T, typename enable_if<is_integral<T>::value && !is_same<T, bool>::value, int>::type = 0>
+    BigInt &operator+=(T value)
+    {
+        addSmall(nativeMagnitude(value), nativeIsNegative(value));
+        return *this;
+    }
+
+    template <typename T, typename enable_if<is_integral<T>::value && !is_same<T, bool>::value, int>::type = 0>
+    BigInt &operator-=(T value)
+    {
+        addSmall(nativeMagnitude(value), !nativeIsNegative(value));
+        return *this;
+    }
+
+    template <typename T, typename enable_if<is_integral<T>::value && !is_same<T, bool>::value, int>::type = 0>
+    BigInt &operator*=(T value)
+    {
+        bool negative = isNegative != nativeIsNegative(value);
+        mulSmall(nativeMagnitude(value));
+        isNegative = negative && !isZero();
+        return *this;
+    }
+
+    template <typename T, typename enable_if<is_integral<T>::value && !is_same<T, bool>::value, int>::type = 0>
+    BigInt &operator/=(T value)
+    {
+        uint64_t divisor = nativeMagnitude(value);
+        if (divisor == 0)
+        {
+            throw runtime_error("Division by zero");
+        }
+        if (divisor > UINT64_MAX / 10)
+        {
+            return *this /= BigInt((nativeIsNegative(value) ? "-" : "") + to_string(divisor));
+        }
+        bool negative = isNegative != nativeIsNegative(value);
+        divideMagnitudeSmall(divisor);
+        isNegative = negative && !isZero();
+        return *this;
+    }
+
+    template <typename T, typename enable_if<is_integral<T>::value && !is_same<T, bool>::value, int>::type = 0>
+    BigInt &operator%=(T value)
+    {
+        uint64_t divisor = nativeMagnitude(value);
+        if (divisor == 0)
+        {
+            throw runtime_error("modulus by zero");
+        }
+        if (divisor > UINT64_MAX / 10)
+        {
+            return *this %= BigInt(to_string(divisor));
+        }
+        bool negative = isNegative;
+        number = to_string(remainderSmall(divisor));
+        isNegative = negative && !isZero();
+        return *this;
+    }
+
+    // Pre-increment operator (++x)
+    BigInt &operator++()
+    {
+        *this += 1;
+        return *this;
+    }
+
+    // Post-increment operator (x++)
+    BigInt operator++(int)
+    {
+        BigInt temp = *this;
+        *this += 1;
+        return temp;
+    }
+
+    // Pre-decrement operator (--x)
+    BigInt &operator--()
+    {
+        *this -= 1;
+        return *this;
+    }
+
+    // Post-decrement operator (x--)
+    BigInt operator--(int)
+    {
+        BigInt temp(*this);
+        *this -= 1;
+        return temp;
+    }
+
+    // Multiply by 10^k in place (append k zero digits)
+    BigInt &shiftDigitsLeft(size_t k)
+    {
+        if (!isZero())
+        {
+            number.edit().append(k, '0');
+        }
+        return *this;
+    }
+
+    // Divide by 10^k in place, truncating toward zero (drop k low digits)
+    BigInt &shiftDigitsRight(size_t k)
+    {
+        if (k >= digitCount())
+        {
+            number = "0";
+            isNegative = false;
+        }
+        else if (k > 0)
+        {
+            string &digits = number.edit();
+            digits.resize(digits.size() - k);
+        }
+        return *this;
+    }
+
+    // Convert BigInt to string representation
+    string toString() const
+    {
+        if (isNegative && !isZero())
+        {
+            return "-" + number.str(); // return the number with the sign if negative
+        }
+
+        return number.str(); // return the number if zero or positive
+    }
+
+    // Output stream operator (for printing)
+    friend ostream &operator<<(ostream &os, const BigInt &num)
+    {
+        os << num.toString();
+        return os;
+    }
+
+    // Input stream operator (for reading from input)
+    friend istream &operator>>(istream &is, BigInt &num)
+    {
+
+        string str;
+        is >> str;
+        num = BigInt(str);
+        return is;
+    }
+
+    // Friend declarations for comparison operators
+    friend bool operator==(const BigInt &lhs, const BigInt &rhs);
+    friend bool operator<(const BigInt &lhs, const BigInt &rhs);
+
+    // using getters for decleraition number and isNegative in binary opertators
+    string getNumber() const
+    {
+        TITAN_OP_SCOPE(OP_GET_NUMBER, digitCount(), 0);
+        return number.str();
+    }
+    // Parity from the last decimal digit
+    bool isEven() const
+    {
+        const string &digits = number.str();
+        return (digits.back() - '0') % 2 == 0;
+    }
+    bool isZero() const
+    {
+        const string &digits = number.str();
+        return digits.size() == 1 && digits[0] == '0';
+    }
+    // Number of decimal digits in the magnitude (no copy, unlike getNumber)
+    size_t digitCount() const
+    {
+        return number.str().size();
+    }
+    // True while this value shares its digit buffer with another BigInt
+    bool sharesStorage() const
+    {
+        return number.isShared();
+    }
+
+    // Room for a value of `digits` digits, e.g. before a run of in-place adds
+    void reserve(size_t digits)
+    {
+        number.reserve(digits);
+    }
+
+    // Returns capacity left over from in-place growth (own buffers only)
+    void shrinkToFit()
+    {
+        number.shrinkToFit();
+    }
+
+    // Bytes this value keeps alive: the object plus its digit buffer, the
+    // buffer counted in full even when shared
+    size_t memoryUsage() const
+    {
+        return sizeof(BigInt) + number.bufferBytes();
+    }
+
+    // Hash of sign and magnitude; the magnitude part is cached in the
+    // digit buffer and recomputed only after a mutation
+    size_t hash() const
+    {
+        uint64_t h = number.hash();
+        return (size_t)(isNegative ? (h ^ 0x8000000000000001ULL) * 0x9e3779b97f4a7c15ULL : h);
+    }
+
+    // Value equality without copying the digits. Shared buffers are equal
+    // by pointer; two interned buffers are equal only if they are the same
+    // buffer; differing cached hashes rule equality out before any scan.
+    bool equals(const BigInt &other) const
+    {
+        if (isNegative != other.isNegative)
+        {
+            return false;
+        }
+        if (number.sameBuffer(other.number))
+        {
+            return true;
+        }
+        if (number.isInterned() && other.number.isInterned())
+        {
+            return false;
+        }
+        uint64_t h1 = number.cachedHash(), h2 = other.number.cachedHash();
+        if (h1 && h2 && h1 != h2)
+        {
+            return false;
+        }
+        return number.str() == other.number.str();
+    }
+
+    // True if this value uses the canonical buffer of the intern table
+    bool isInterned() const
+    {
+        return number.isInterned();
+    }
+
+    // Canonical instance from the global intern table (see BigIntInternTable)
+    BigInt interned() const;
+
+    friend class BigIntInternTable;
+    friend class Accumulator;
+    bool getIsNegative() const
+    {
+        return isNegative;
+    }
+    void setNumber(const string &num)
+    {
+        number = num;
+    }
+    void setIsNegative(bool neg)
+    {
+        isNegative = neg;
+    }
+};
+
+// Binary addition operator (x + y)
+
+BigInt operator+(BigInt lhs, const BigInt &rhs)
+{
+    TITAN_TRACE_SCOPE("BigInt::add");
+    TITAN_OP_SCOPE(OP_ADD, lhs.digitCount(), rhs.digitCount());
+    if (lhs.getIsNegative() == rhs.getIsNegative())
+    {
+        string a = lhs.getNumber(), b = rhs.getNumber();
+        if (a.size() < b.size())
+            swap(a, b);
+        int carry = 0;
+        int n = a.size(), m = b.size();
+        string result = "";
+        TITAN_OP_TIER(OP_ADD, TIER_SCHOOLBOOK);
+        for (int i = 0; i < n; i++)
+        {
+            int da = a[n - 1 - i] - '0';
+            int db = (i < m) ? (b[m - 1 - i] - '0') : 0;
+            int sum = da + db + carry;
+            carry = sum / 10;
+            result.push_back((sum % 10) + '0');
+        }
+        if (carry)
+            result.push_back(carry + '0');
+        reverse(result.begin(), result.end());
+        BigInt res;
+        res.setNumber(result);
+        res.setIsNegative(lhs.getIsNegative());
+        return res;
+    }
+    else
+    {
+        return lhs - (-rhs);
+    }
+}
+
+// Binary subtraction operator (x - y)
+
+BigInt operator-(BigInt lhs, const BigInt &rhs)
+{
+    TITAN_TRACE_SCOPE("BigInt::sub");
+    TITAN_OP_SCOPE(OP_SUB, lhs.digitCount(), rhs.digitCount());
+    // A zero rhs goes down the magnitude path; bouncing it back to operator+
+    // would recurse forever for a negative lhs
+    if (lhs.getIsNegative() != rhs.getIsNegative() && !rhs.isZero())
+    {
+        return lhs + (-rhs);
+    }
+    int cmp = lhs.compareMagnitude(rhs);
+    if (cmp == 0)
+        return BigInt(0);
+
+    bool resultNegative = false;
+    string a = lhs.getNumber(), b = rhs.getNumber();
+    if (cmp < 0)
+    {
+        swap(a, b);
+        resultNegative = true;
+    }
+    int n = a.size(), m = b.size();
+    string result = "";
+    int borrow = 0;
+    TITAN_OP_TIER(OP_SUB, TIER_SCHOOLBOOK);
+    for (int i = 0; i < n; i++)
+    {
+        int da = a[n - 1 - i] - '0' - borrow;
+        int db = (i < m) ? (b[m - 1 - i] - '0') : 0;
+        if (da < db)
+        {
+            da += 10;
+            borrow = 1;
+        }
+        else
+        {
+            borrow = 0;
+        }
+        result.push_back((da - db) + '0');
+    }
+    while (result.size() > 1 && result.back() == '0')
+        result.pop_back();
+    reverse(result.begin(), result.end());
+
+    BigInt res;
+    res.setNumber(result);
+    res.setIsNegative(lhs.getIsNegative() ? !resultNegative : resultNegative);
+    if (res.isZero())
+        res.setIsNegative(false);
+    return res;
+}
+
+// Binary multiplication operator (x * y)
+
+BigInt operator*(BigInt lhs, const BigInt &rhs)
+{
+    TITAN_TRACE_SCOPE("BigInt::mul");
+    TITAN_OP_SCOPE(OP_MUL, lhs.digitCount(), rhs.digitCount());
+    Limbs a = toLimbs(lhs.getNumber()), b = toLimbs(rhs.getNumber());
+    trimLimbs(a);
+    trimLimbs(b);
+#ifdef TITANINT_INSTRUMENT
+    if (min(a.size(), b.size()) < KARATSUBA_THRESHOLD)
+        TITAN_OP_TIER(OP_MUL, TIER_SCHOOLBOOK);
+    else
+        TITAN_OP_TIER(OP_MUL, TIER_KARATSUBA);
+#endif
+    // Squares (pow, isqrt, x * x) take the squaring kernel; telling them
+    // apart costs one limb comparison, which stops at the first difference
+    string resStr = fromLimbs(a == b ? sqrLimbs(a) : mulLimbs(a, b));
+    BigInt res;
+    res.setNumber(resStr);
+    res.setIsNegative(lhs.getIsNegative() != rhs.getIsNegative() && resStr != "0");
+    return res;
+}
+
+// Binary division operator (x / y)
+BigInt operator/(BigInt lhs, const BigInt &rhs)
+{
+    TITAN_TRACE_SCOPE("BigInt::div");
+    TITAN_OP_SCOPE(OP_DIV, lhs.digitCount(), rhs.digitCount());
+    if (rhs.isZero())
+    {
+        throw runtime_error("Division by zero");
+    }
+
+    if (lhs.compareMagnitude(rhs) < 0)
+    {
+        return BigInt(0);
+    }
+
+    BigInt dividend = lhs;
+    BigInt divisor = rhs;
+    dividend.setIsNegative(false);
+    divisor.setIsNegative(false);
+
+    uint64_t smallDivisor;
+    if (divisor.magnitudeToUint64(smallDivisor) && smallDivisor <= UINT64_MAX / 10)
+    {
+        dividend.divideMagnitudeSmall(smallDivisor);
+        dividend.setIsNegative(lhs.getIsNegative() != rhs.getIsNegative() && !dividend.isZero());
+        return dividend;
+    }
+
+    // Quotient from a Newton reciprocal: a few multiplications instead of
+    // a trial-subtraction pass per quotient digit
+    TITAN_OP_TIER(OP_DIV, TIER_NEWTON);
+    BigInt result = divmodNewton(dividend, divisor).first;
+    result.setIsNegative(lhs.getIsNegative() != rhs.getIsNegative() && !result.isZero());
+    return result;
+}
+
+// Binary modulus operator (x % y)
+BigInt operator%(BigInt lhs, const BigInt &rhs)
+{
+    TITAN_TRACE_SCOPE("BigInt::mod");
+    TITAN_OP_SCOPE(OP_MOD, lhs.digitCount(), rhs.digitCount());
+    if (rhs.isZero())
+    {
+        throw runtime_error("modulus by zero");
+    }
+    if (lhs.compareMagnitude(rhs) < 0)
+    {
+        return lhs;
+    }
+    uint64_t smallDivisor;
+    if (rhs.magnitudeToUint64(smallDivisor) && smallDivisor <= UINT64_MAX / 10)
+    {
+        return lhs %= smallDivisor;
+    }
+    TITAN_OP_TIER(OP_MOD, TIER_NEWTON);
+    BigInt dividend = lhs, divisor = rhs;
+    dividend.setIsNegative(false);
+    divisor.setIsNegative(false);
+    BigInt result = divmodNewton(dividend, divisor).second;
+    result.setIsNegative(lhs.getIsNegative() && !result.isZero());
+    return result;
+}
+
+// Native integer right operands (x + 1, x * 10, x / 1000, x % 7)
+template <typename T, typename enable_if<is_integral<T>::value && !is_same<T, bool>::value, int>::type = 0>
+BigInt operator+(BigInt lhs, T rhs)
+{
+    return lhs += rhs;
+}
+
+template <typename T, typename enable_if<is_integral<T>::value && !is_same<T, bool>::value, int>::type = 0>
+BigInt operator-(BigInt lhs, T rhs)
+{
+    return lhs -= rhs;
+}
+
+template <typename T, typename enable_if<is_integral<T>::value && !is_same<T, bool>::value, int>::type = 0>
+BigInt operator*(BigInt lhs, T rhs)
+{
+    return lhs *= rhs;
+}
+
+template <typename T, typename enable_if<is_integral<T>::value && !is_same<T, bool>::value, int>::type = 0>
+BigInt operator/(BigInt lhs, T rhs)
+{
+    return lhs /= rhs;
+}
+
+template <typename T, typename enable_if<is_integral<T>::value && !is_same<T, bool>::value, int>::type = 0>
+BigInt operator%(BigInt lhs, T rhs)
+{
+    return lhs %= rhs;
+}
+
+// Hash support so BigInt works as an unordered_map / unordered_set key
+namespace std
+{
+    template <>
+    struct hash<BigInt>
+    {
+        size_t operator()(const BigInt &value) const noexcept
+        {
+            return value.hash();
+        }
+    };
+}
+
+// Equality comparison operator (x == y)
+bool operator==(const BigInt &lhs, const BigInt &rhs)
+{
+    return lhs.equals(rhs);
+}
+// Inequality comparison operator (x != y)
+bool operator!=(const BigInt &lhs, const BigInt &rhs)
+{
+    return !(lhs == rhs);
+}
+
+// Less-than comparison operator (x < y)
+bool operator<(const BigInt &lhs, const BigInt &rhs)
+{
+    return lhs.compare(rhs) < 0;
+}
+
+// Less-than-or-equal comparison operator (x <= y)
+bool operator<=(const BigInt &lhs, const BigInt &rhs)
+{
+    return lhs.compare(rhs) <= 0;
+}
+
+// Greater-than comparison operator (x > y)
+bool operator>(const BigInt &lhs, const BigInt &rhs)
+{
+    return lhs.compare(rhs) > 0;
+}
+
+// Greater-than-or-equal comparison operator (x >= y)
+bool operator>=(const BigInt &lhs, const BigInt &rhs)
+{
+    return lhs.compare(rhs) >= 0;
+}
+
+#if __cplusplus >= 202002L
+// Three-way comparison (x <=> y) when built as C++20
+strong_ordering operator<=>(const BigInt &lhs, const BigInt &rhs)
+{
+    return lhs.compare(rhs) <=> 0;
+}
+#endif
+
+// ==================== INTERNING ====================
+// Hash-consing table: every distinct magnitude has one canonical digit
+// buffer, and interned values (of either sign) share it. Equality between
+// interned values is then a pointer comparison (see BigInt::equals). The
+// table is split into shards with their own lock so many threads can
+// intern at once. Only the table's own entries are flagged; under
+// -DTITANINT_DEEP_COPY copies never share them, so interned() returns a
+// plain equal value and equality compares digits.
+
+class BigIntInternTable
+{
+    static const size_t SHARD_COUNT = 64;
+
+    struct Shard
+    {
+        mutex lock;
+        unordered_set<BigInt> values; // non-negative canonical values
+    };
+    Shard shards[SHARD_COUNT];
+
+    Shard &shardFor(uint64_t h)
+    {
+        return shards[(h >> 58) % SHARD_COUNT];
+    }
+
+public:
+    // Canonical instance equal to value
+    BigInt intern(const BigInt &value)
+    {
+        if (value.isInterned())
+        {
+            return value;
+        }
+        BigInt magnitude = value;
+        magnitude.isNegative = false;
+        Shard &shard = shardFor(magnitude.number.hash());
+        BigInt canonical;
+        {
+            lock_guard<mutex> guard(shard.lock);
+            auto inserted = shard.values.insert(magnitude);
+            if (inserted.second)
+            {
+                inserted.first->number.setInterned(true);
+            }
+            canonical = *inserted.first;
+        }
+        canonical.isNegative = value.isNegative;
+        return canonical;
+    }
+
+    // Number of distinct magnitudes held
+    size_t size()
+    {
+        size_t total = 0;
+        for (Shard &shard : shards)
+        {
+            lock_guard<mutex> guard(shard.lock);
+            total += shard.values.size();
+        }
+        return total;
+    }
+
+    // Drop every entry. Buffers still referenced elsewhere lose their
+    // canonical status, so pointer equality is never trusted for them again.
+    void clear()
+    {
+        for (Shard &shard : shards)
+        {
+            lock_guard<mutex> guard(shard.lock);
+            for (const BigInt &value : shard.values)
+            {
+                value.number.setInterned(false);
+            }
+            shard.values.clear();
+        }
+    }
+};
+
+// Process-wide intern table used by BigInt::interned()
+BigIntInternTable &internTable()
+{
+    static BigIntInternTable table;
+    return table;
+}
+
+BigInt BigInt::interned() const
+{
+    return internTable().intern(*this);
+}
+
+// ==================== POWERS AND ROOTS ====================
+
+// Integer power (base ^ exp) by left-to-right binary exponentiation:
+// one squaring per exponent bit (through sqrLimbs, as result * result
+// has equal operands) plus one multiply per set bit
+BigInt pow(const BigInt &base, uint64_t exp)
+{
+    if (exp == 0)
+    {
+        return BigInt(1);
+    }
+    int bit = 63;
+    while (!((exp >> bit) & 1))
+    {
+        --bit;
+    }
+    BigInt result = base;
+    for (--bit; bit >= 0; --bit)
+    {
+        result = result * result;
+        if ((exp >> bit) & 1)
+        {
+            result = result * base;
+        }
+    }
+    return result;
+}
+
+// Value of a non-negative BigInt with at most 19 digits
+static uint64_t smallMagnitude(const BigInt &n)
+{
+    return stoull(n.getNumber());
+}
+
+// floor(sqrt(v)) for a 64-bit value, corrected after the floating point estimate
+static uint64_t isqrtSmall(uint64_t v)
+{
+    uint64_t r = (uint64_t)sqrtl((long double)v);
+    while (r > 0 && (r > UINT32_MAX || r * r > v))
+        --r;
+    while (r + 1 <= UINT32_MAX && (r + 1) * (r + 1) <= v)
+        ++r;
+    return r;
+}
+
+// Y ~ 10^(3m) / sqrt(n) for n with exactly 2m digits, within a few units.
+// Precision doubling: the top half of the digits gives a half-precision
+// estimate, and one Newton step y += y(1 - n*y^2)/2 on the inverse square
+// root doubles it. Only multiplications and decimal shifts are used, so the
+// cost is a small multiple of one full-size multiplication.
+static BigInt inverseSqrtScaled(const BigInt &n, size_t m)
+{
+    if (m <= 8)
+    {
+        long double value = (long double)smallMagnitude(n);
+        return BigInt((int64_t)(powl(10.0L, 3 * m) / sqrtl(value)));
+    }
+
+    size_t h = m / 2 + 2; // two guard digits absorb truncation error
+    BigInt top = n;
+    top.shiftDigitsRight(2 * (m - h));
+    BigInt y = inverseSqrtScaled(top, h);
+    y.shiftDigitsLeft(2 * (m - h)); // 10^(3h)/sqrt(top) -> 10^(3m)/sqrt(n)
+
+    // e = 10^(6m) - n*y^2 is the scaled residual of the current estimate
+    BigInt one(1);
+    one.shiftDigitsLeft(6 * m);
+    BigInt e = one - n * (y * y);
+    BigInt correction = y * e * 5;
+    correction.shiftDigitsRight(6 * m + 1); // halve via *5 / 10
+    return y + correction;
+}
+
+// Integer square root floor(sqrt(n)), throws for negative n
+BigInt isqrt(const BigInt &n)
+{
+    if (n.getIsNegative())
+    {
+        throw runtime_error("Square root of negative number");
+    }
+    size_t digits = n.digitCount();
+    if (digits <= 19)
+    {
+        return BigInt((int64_t)isqrtSmall(smallMagnitude(n)));
+    }
+
+    // Work on an even digit count; floor(sqrt(100n)) / 10 == floor(sqrt(n))
+    BigInt even = n;
+    bool padded = digits % 2 != 0;
+    if (padded)
+    {
+        even.shiftDigitsLeft(2);
+        ++digits;
+    }
+    size_t m = digits / 2;
+
+    BigInt root = even * inverseSqrtScaled(even, m);
+    root.shiftDigitsRight(3 * m);
+
+    // The estimate is off by at most a few units; settle it exactly
+    BigInt square = root * root;
+    while (square > even)
+    {
+        square = square - root - root + 1;
+        --root;
+    }
+    BigInt next = square + root + root + 1;
+    while (next <= even)
+    {
+        ++root;
+        next = next + root + root + 1;
+    }
+
+    if (padded)
+    {
+        root.shiftDigitsRight(1);
+    }
+    return root;
+}
+
+// Integer k-th root: the largest r with r^k <= n (toward zero for negative n)
+BigInt iroot(const BigInt &n, uint64_t k)
+{
+    if (k == 0)
+    {
+        throw runtime_error("Zeroth root is undefined");
+    }
+    if (n.getIsNegative())
+    {
+        if (k % 2 == 0)
+        {
+            throw runtime_error("Even root of negative number");
+        }
+        return -iroot(-n, k);
+    }
+    if (k == 1 || (n.digitCount() == 1 && n.getNumber()[0] <= '1'))
+    {
+        return n;
+    }
+    if (k == 2)
+    {
+        return isqrt(n);
+    }
+    if (k >= n.digitCount() * 4) // 2^k > n, so the root is 1
+    {
+        return BigInt(1);
+    }
+
+    // Start strictly above the root from a 15 significant digit estimate;
+    // Newton's iteration then decreases monotonically onto the floor root.
+    size_t digits = n.digitCount();
+    size_t lead = min<size_t>(digits, 18);
+    long double log10n = log10l((long double)stoull(n.getNumber().substr(0, lead))) + (long double)(digits - lead);
+    long double log10r = log10n / k;
+    size_t shift = log10r > 15 ? (size_t)(log10r - 15) : 0;
+    BigInt x((int64_t)(powl(10.0L, log10r - shift) * (1 + 1e-12L)) + 2);
+    x.shiftDigitsLeft(shift);
+    while (pow(x, k) <= n)
+    {
+        x *= 2;
+    }
+
+    while (true)
+    {
+        BigInt next = (x * (k - 1) + n / pow(x, k - 1)) / k;
+        if (next >= x)
+        {
+            return x;
+        }
+        x = next;
+    }
+}
+
+// True if r is a square modulo m (small m only)
+static bool isQuadraticResidue(int r, int m)
+{
+    for (int x = 0; x <= m / 2; x++)
+    {
+        if ((x * x) % m == r)
+            return true;
+    }
+    return false;
+}
+
+// Exact square test. Cheap residue filters on the decimal digits reject
+// most non-squares before the square root is taken: the last two digits
+// (squares mod 100), the digit sum (mod 9) and the alternating sum of
+// three-digit groups (mod 1001 = 7 * 11 * 13).
+bool isPerfectSquare(const BigInt &n)
+{
+    if (n.getIsNegative())
+    {
+        return false;
+    }
+    string digits = n.getNumber();
+    size_t len = digits.size();
+
+    int lastTwo = (len >= 2 ? (digits[len - 2] - '0') * 10 : 0) + (digits[len - 1] - '0');
+    if (!isQuadraticResidue(lastTwo, 100))
+    {
+        return false;
+    }
+
+    int digitSum = 0;
+    for (char c : digits)
+    {
+        digitSum += c - '0';
+        if (digitSum >= 9)
+            digitSum -= 9;
+    }
+    if (digitSum != 0 && digitSum != 1 && digitSum != 4 && digitSum != 7)
+    {
+        return false;
+    }
+
+    // 1000 == -1 (mod 1001), so alternate the signs of three-digit groups
+    long long alternating = 0;
+    int sign = 1;
+    for (size_t end = len; end > 0; end = end >= 3 ? end - 3 : 0)
+    {
+        int group = 0;
+        for (size_t i = end >= 3 ? end - 3 : 0; i < end; i++)
+            group = group * 10 + (digits[i] - '0');
+        alternating += sign * group;
+        sign = -sign;
+    }
+    int r1001 = (int)(((alternating % 1001) + 1001) % 1001);
+    if (!isQuadraticResidue(r1001 % 7, 7) || !isQuadraticResidue(r1001 % 11, 11) || !isQuadraticResidue(r1001 % 13, 13))
+    {
+        return false;
+    }
+
+    BigInt root = isqrt(n);
+    return root * root == n;
+}
+
+// ==================== PRODUCTS AND FACTORIALS ====================
+// All products are formed with balanced product trees so that every
+// multiplication sees operands of similar size (where Karatsuba pays off),
+// instead of one accumulator that grows by a small factor per step.
+// The two halves of large trees are multiplied on separate threads.
+
+// Subtrees smaller than this many factors are multiplied sequentially;
+// tunable (see TUNING)
+size_t PRODUCT_TREE_LEAF = 16;
+// Trees with fewer factors than this are never split across threads
+const size_t PRODUCT_PARALLEL_MIN = 512;
+
+static BigInt productTree(const vector<BigInt> &factors, size_t lo, size_t hi, unsigned threads)
+{
+    if (hi - lo <= PRODUCT_TREE_LEAF)
+    {
+        BigInt result(1);
+        for (size_t i = lo; i < hi; i++)
+            result = result * factors[i];
+        return result;
+    }
+    size_t mid = lo + (hi - lo) / 2;
+    if (threads > 1 && hi - lo >= PRODUCT_PARALLEL_MIN)
+    {
+        future<BigInt> left = async(launch::async, productTree, cref(factors), lo, mid, threads / 2);
+        BigInt right = productTree(factors, mid, hi, threads - threads / 2);
+        return left.get() * right;
+    }
+    return productTree(factors, lo, mid, 1) * productTree(factors, mid, hi, 1);
+}
+
+// Product of all elements of a vector (1 for an empty vector)
+BigInt product(const vector<BigInt> &factors)
+{
+    TITAN_TRACE_SCOPE("product");
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    return productTree(factors, 0, factors.size(), threads);
+}
+
+// Product of any range whose elements convert to BigInt
+template <typename Iterator>
+BigInt product(Iterator first, Iterator last)
+{
+    return product(vector<BigInt>(first, last));
+}
+
+// Sieve of Eratosthenes: all primes <= n
+static vector<uint64_t> primesUpTo(uint64_t n)
+{
+    vector<uint64_t> primes;
+    if (n < 2)
+        return primes;
+    vector<bool> composite(n + 1, false);
+    for (uint64_t p = 2; p <= n; p++)
+    {
+        if (composite[p])
+            continue;
+        primes.push_back(p);
+        for (uint64_t q = p * p; q <= n; q += p)
+            composite[q] = true;
+    }
+    return primes;
+}
+
+// Turn prime powers p^e into BigInt factors, packing as many small factors
+// into one 63-bit word as fit so the product tree has fewer leaves
+static vector<BigInt> packPrimePowers(const vector<uint64_t> &primes, const vector<uint64_t> &exponents)
+{
+    vector<BigInt> factors;
+    uint64_t word = 1;
+    for (size_t i = 0; i < primes.size(); i++)
+    {
+        for (uint64_t e = 0; e < exponents[i]; e++)
+        {
+            if (word > (uint64_t)INT64_MAX / primes[i])
+            {
+                factors.push_back(BigInt((int64_t)word));
+                word = 1;
+            }
+            word *= primes[i];
+        }
+    }
+    if (word > 1)
+        factors.push_back(BigInt((int64_t)word));
+    return factors;
+}
+
+// Exponent of prime p in the swing number n!/(floor(n/2)!)^2:
+// the number of odd values among floor(n/p^k), k >= 1
+static uint64_t swingExponent(uint64_t n, uint64_t p)
+{
+    uint64_t e = 0;
+    for (uint64_t q = n / p; q > 0; q /= p)
+        e += q & 1;
+    return e;
+}
+
+static BigInt swingFactorial(uint64_t n, const vector<uint64_t> &primes)
+{
+    vector<uint64_t> used, exponents;
+    for (uint64_t p : primes)
+    {
+        if (p > n)
+            break;
+        uint64_t e = swingExponent(n, p);
+        if (e)
+        {
+            used.push_back(p);
+            exponents.push_back(e);
+        }
+    }
+    return product(packPrimePowers(used, exponents));
+}
+
+static BigInt factorialRecursive(uint64_t n, const vector<uint64_t> &primes)
+{
+    if (n < 21) // 20! still fits in int64_t
+    {
+        int64_t f = 1;
+        for (uint64_t i = 2; i <= n; i++)
+            f *= (int64_t)i;
+        return BigInt(f);
+    }
+    BigInt half = factorialRecursive(n / 2, primes);
+    return half * half * swingFactorial(n, primes);
+}
+
+// n! by Luschny's prime swing: n! = (floor(n/2)!)^2 * swing(n), where the
+// swing number is assembled from its prime factorization
+BigInt factorial(uint64_t n)
+{
+    TITAN_TRACE_SCOPE("factorial");
+    return factorialRecursive(n, primesUpTo(n));
+}
+
+// Exponent of prime p in n! (Legendre's formula)
+static uint64_t legendreExponent(uint64_t n, uint64_t p)
+{
+    uint64_t e = 0;
+    for (uint64_t q = n / p; q > 0; q /= p)
+        e += q;
+    return e;
+}
+
+// Binomial coefficient C(n, k) from its prime factorization (0 if k > n)
+BigInt binomial(uint64_t n, uint64_t k)
+{
+    TITAN_TRACE_SCOPE("binomial");
+    if (k > n)
+    {
+        return BigInt(0);
+    }
+    k = min(k, n - k);
+    vector<uint64_t> primes = primesUpTo(n), exponents;
+    for (uint64_t p : primes)
+    {
+        exponents.push_back(legendreExponent(n, p) - legendreExponent(k, p) - legendreExponent(n - k, p));
+    }
+    return product(packPrimePowers(primes, exponents));
+}
+
+// Product of all primes <= n
+BigInt primorial(uint64_t n)
+{
+    TITAN_TRACE_SCOPE("primorial");
+    vector<uint64_t> primes = primesUpTo(n);
+    return product(packPrimePowers(primes, vector<uint64_t>(primes.size(), 1)));
+}
+
+// ==================== GREATEST COMMON DIVISOR ====================
+
+// Lehmer's gcd over base 10^9 limbs. Each pass runs Euclid on the
+// leading 18 digits of both operands only, collecting the quotients in a
+// 2x2 cofactor matrix, and then applies the matrix to the full operands
+// in one linear pass. A pass removes about nine digits (the cofactors are
+// kept below 10^9 so every product fits in 64 bits), so the whole gcd
+// costs O(n^2) word operations. A pass that cannot proceed (a huge
+// quotient) takes one full division step with operator% instead.
+
+// floor(x / 10^shift), for values where that is below 10^18
+static uint64_t leadingDigits(const Limbs &x, size_t shift)
+{
+    static const uint64_t powers[] = {1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+                                      10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+                                      100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+                                      100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+                                      100000000000000000ULL, 1000000000000000000ULL};
+    size_t k = shift / LIMB_DIGITS, r = shift % LIMB_DIGITS;
+    auto limb = [&](size_t i) -> uint64_t { return i < x.size() ? x[i] : 0; };
+    return limb(k + 2) * powers[18 - r] + limb(k + 1) * powers[9 - r] + limb(k) / powers[r];
+}
+
+// out = p * x + q * y for cofactors below 10^9 in magnitude, where the
+// result is known to be non-negative
+static void combineLimbs(Limbs &out, const Limbs &x, int64_t p, const Limbs &y, int64_t q)
+{
+    out.assign(x.size(), 0);
+    int64_t carry = 0;
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        int64_t t = p * x[i] + (i < y.size() ? q * y[i] : 0) + carry;
+        carry = t / (int64_t)LIMB_BASE;
+        t %= (int64_t)LIMB_BASE;
+        if (t < 0)
+        {
+            t += LIMB_BASE;
+            --carry;
+        }
+        out[i] = (uint32_t)t;
+    }
+    trimLimbs(out);
+}
+
+static size_t limbsDigitCount(const Limbs &x)
+{
+    size_t digits = (x.size() - 1) * LIMB_DIGITS + 1;
+    for (uint32_t top = x.back(); top >= 10; top /= 10)
+        ++digits;
+    return digits;
+}
+
+// Non-negative greatest common divisor; gcd(0, 0) == 0
+BigInt gcd(BigInt a, BigInt b)
+{
+    TITAN_TRACE_SCOPE("gcd");
+    a.setIsNegative(false);
+    b.setIsNegative(false);
+    if (a.compareMagnitude(b) < 0)
+        swap(a, b);
+    if (b.isZero())
+        return a;
+
+    Limbs x = toLimbs(a.getNumber()), y = toLimbs(b.getNumber()), nx, ny;
+    trimLimbs(x);
+    trimLimbs(y);
+    // x > y > 0 throughout
+    while (!y.empty() && limbsDigitCount(x) > 18)
+    {
+        size_t shift = limbsDigitCount(x) - 18;
+        int64_t xh = (int64_t)leadingDigits(x, shift), yh = (int64_t)leadingDigits(y, shift);
+        int64_t A = 1, B = 0, C = 0, D = 1;
+        while (yh + C > 0 && yh + D > 0)
+        {
+            int64_t q = (xh + A) / (yh + C);
+            if (q != (xh + B) / (yh + D) || q >= (int64_t)LIMB_BASE)
+                break;
+            int64_t nextC = A - q * C, nextD = B - q * D;
+            if (max(llabs(nextC), llabs(nextD)) >= (int64_t)LIMB_BASE)
+                break;
+            A = C;
+            B = D;
+            C = nextC;
+            D = nextD;
+            int64_t remainder = xh - q * yh;
+            xh = yh;
+            yh = remainder;
+        }
+
+        if (B == 0)
+        {
+            BigInt dividend, divisor;
+            dividend.setNumber(fromLimbs(x));
+            divisor.setNumber(fromLimbs(y));
+            x.swap(y);
+            y = toLimbs((dividend % divisor).getNumber());
+            trimLimbs(y);
+        }
+        else
+        {
+            combineLimbs(nx, x, A, y, B);
+            combineLimbs(ny, x, C, y, D);
+            x.swap(nx);
+            y.swap(ny);
+        }
+    }
+
+    if (y.empty())
+    {
+        BigInt result;
+        result.setNumber(fromLimbs(x));
+        return result;
+    }
+    // Both below 10^18 now
+    uint64_t u = x.size() > 1 ? (uint64_t)x[1] * LIMB_BASE + x[0] : x[0];
+    uint64_t v = y.size() > 1 ? (uint64_t)y[1] * LIMB_BASE + y[0] : y[0];
+    while (v != 0)
+    {
+        uint64_t r = u % v;
+        u = v;
+        v = r;
+    }
+    return BigInt((int64_t)u);
+}
+
+// ==================== RATIONAL NUMBERS ====================
+// BigRational keeps numerator / denominator (denominator > 0) and reduces
+// lazily. Small operands are combined with the plain formulas and reduced
+// only once the denominator outgrows RATIONAL_REDUCE_DIGITS; large operands
+// are reduced first and combined with cross-cancellation (Henrici), which
+// takes the gcds of the smaller cross terms and yields a reduced result
+// without ever forming the unreduced product.
+
+// Denominators longer than this many digits trigger reduction
+const size_t RATIONAL_REDUCE_DIGITS = 40;
+
+class BigRational
+{
+    // Mutable so const observers (printing, equality) can reduce lazily
+    mutable BigInt num;
+    mutable BigInt den;
+    mutable bool reduced;
+
+    bool isLarge() const
+    {
+        return den.digitCount() > RATIONAL_REDUCE_DIGITS || num.digitCount() > RATIONAL_REDUCE_DIGITS;
+    }
+
+    void reduceIfLarge() const
+    {
+        if (!reduced && isLarge())
+        {
+            normalize();
+        }
+    }
+
+    static BigRational raw(const BigInt &n, const BigInt &d, bool isReduced)
+    {
+        BigRational r;
+        r.num = n;
+        r.den = d;
+        r.reduced = isReduced || n.isZero() || d == BigInt(1);
+        if (r.num.isZero())
+            r.den = BigInt(1);
+        r.reduceIfLarge();
+        return r;
+    }
+
+public:
+    // Default constructor - initialize to zero
+    BigRational() : num(0), den(1), reduced(true) {}
+
+    // Constructor from an integer
+    BigRational(const BigInt &value) : num(value), den(1), reduced(true) {}
+
+    BigRational(int64_t value) : num(value), den(1), reduced(true) {}
+
+    // Constructor from numerator and denominator
+    BigRational(const BigInt &numerator, const BigInt &denominator) : num(numerator), den(denominator), reduced(false)
+    {
+        if (den.isZero())
+        {
+            throw runtime_error("Zero denominator");
+        }
+        if (den.getIsNegative())
+        {
+            num = -num;
+            den = -den;
+        }
+        if (num.isZero())
+        {
+            den = BigInt(1);
+            reduced = true;
+        }
+        reduceIfLarge();
+    }
+
+    // Constructor from "p/q" or "p"
+    BigRational(const string &str) : BigRational()
+    {
+        size_t slash = str.find('/');
+        if (slash == string::npos)
+        {
+            *this = BigRational(BigInt(str));
+        }
+        else
+        {
+            *this = BigRational(BigInt(str.substr(0, slash)), BigInt(str.substr(slash + 1)));
+        }
+    }
+
+    // Divide out gcd(num, den)
+    void normalize() const
+    {
+        if (reduced)
+            return;
+        BigInt g = gcd(num, den);
+        if (g != BigInt(1))
+        {
+            num /= g;
+            den /= g;
+        }
+        reduced = true;
+    }
+
+    const BigInt &numerator() const
+    {
+        normalize();
+        return num;
+    }
+
+    const BigInt &denominator() const
+    {
+        normalize();
+        return den;
+    }
+
+    bool isReduced() const
+    {
+        return reduced;
+    }
+
+    bool isZero() const
+    {
+        return num.isZero();
+    }
+
+    // -1, 0 or 1
+    int sign() const
+    {
+        return num.isZero() ? 0 : (num.getIsNegative() ? -1 : 1);
+    }
+
+    // Unary negation operator (-x)
+    BigRational operator-() const
+    {
+        return raw(-num, den, reduced);
+    }
+
+    friend BigRational operator+(const BigRational &lhs, const BigRational &rhs)
+    {
+        if (lhs.isZero())
+            return rhs;
+        if (rhs.isZero())
+            return lhs;
+        if (!lhs.isLarge() && !rhs.isLarge())
+        {
+            if (lhs.den == rhs.den)
+                return raw(lhs.num + rhs.num, lhs.den, false);
+            return raw(lhs.num * rhs.den + rhs.num * lhs.den, lhs.den * rhs.den, false);
+        }
+        lhs.normalize();
+        rhs.normalize();
+        // Henrici: with g = gcd(b, d), a/b + c/d = (a*(d/g) + c*(b/g)) / (b*(d/g)),
+        // and only g can still share factors with that numerator
+        BigInt g = gcd(lhs.den, rhs.den);
+        if (g == BigInt(1))
+        {
+            return raw(lhs.num * rhs.den + rhs.num * lhs.den, lhs.den * rhs.den, true);
+        }
+        BigInt b = lhs.den / g, d = rhs.den / g;
+        BigInt t = lhs.num * d + rhs.num * b;
+        BigInt g2 = gcd(t, g);
+        if (g2 == BigInt(1))
+        {
+            return raw(t, b * rhs.den, true);
+        }
+        return raw(t / g2, b * (rhs.den / g2), true);
+    }
+
+    friend BigRational operator-(const BigRational &lhs, const BigRational &rhs)
+    {
+        return lhs + (-rhs);
+    }
+
+    friend BigRational operator*(const BigRational &lhs, const BigRational &rhs)
+    {
+        if (lhs.isZero() || rhs.isZero())
+            return BigRational();
+        if (!lhs.isLarge() && !rhs.isLarge())
+        {
+            return raw(lhs.num * rhs.num, lhs.den * rhs.den, false);
+        }
+        lhs.normalize();
+        rhs.normalize();
+        // Cross-cancel a/b * c/d by gcd(a, d) and gcd(c, b) before multiplying
+        BigInt g1 = gcd(lhs.num, rhs.den), g2 = gcd(rhs.num, lhs.den);
+        BigInt a = lhs.num, b = lhs.den, c = rhs.num, d = rhs.den;
+        if (g1 != BigInt(1))
+        {
+            a /= g1;
+            d /= g1;
+        }
+        if (g2 != BigInt(1))
+        {
+            c /= g2;
+            b /= g2;
+        }
+        return raw(a * c, b * d, true);
+    }
+
+    // Reciprocal; throws for zero
+    BigRational reciprocal() const
+    {
+        if (isZero())
+        {
+            throw runtime_error("Division by zero");
+        }
+        BigRational r = raw(den, num, reduced);
+        if (r.den.getIsNegative())
+        {
+            r.num = -r.num;
+            r.den = -r.den;
+        }
+        return r;
+    }
+
+    friend BigRational operator/(const BigRational &lhs, const BigRational &rhs)
+    {
+        return lhs * rhs.reciprocal();
+    }
+
+    BigRational &operator+=(const BigRational &other)
+    {
+        *this = *this + other;
+        return *this;
+    }
+
+    BigRational &operator-=(const BigRational &other)
+    {
+        *this = *this - other;
+        return *this;
+    }
+
+    BigRational &operator*=(const BigRational &other)
+    {
+        *this = *this * other;
+        return *this;
+    }
+
+    BigRational &operator/=(const BigRational &other)
+    {
+        *this = *this / other;
+        return *this;
+    }
+
+    // Three-way comparison. Signs and digit counts settle most cases:
+    // |a/b| lies in (10^(len a - len b - 1), 10^(len a - len b + 1)), so
+    // cross-multiplication is needed only when those ranges overlap.
+    static int compare(const BigRational &lhs, const BigRational &rhs)
+    {
+        int ls = lhs.sign(), rs = rhs.sign();
+        if (ls != rs)
+            return ls < rs ? -1 : 1;
+        if (ls == 0)
+            return 0;
+        int magnitude;
+        if (lhs.den == rhs.den)
+        {
+            magnitude = lhs.num.compareMagnitude(rhs.num);
+        }
+        else
+        {
+            long long le = (long long)lhs.num.digitCount() - (long long)lhs.den.digitCount();
+            long long re = (long long)rhs.num.digitCount() - (long long)rhs.den.digitCount();
+            if (le >= re + 2)
+                magnitude = 1;
+            else if (re >= le + 2)
+                magnitude = -1;
+            else
+                magnitude = (lhs.num * rhs.den).compareMagnitude(rhs.num * lhs.den);
+        }
+        return ls > 0 ? magnitude : -magnitude;
+    }
+
+    friend bool operator==(const BigRational &lhs, const BigRational &rhs)
+    {
+        lhs.normalize();
+        rhs.normalize();
+        return lhs.num == rhs.num && lhs.den == rhs.den;
+    }
+    friend bool operator!=(const BigRational &lhs, const BigRational &rhs) { return !(lhs == rhs); }
+    friend bool operator<(const BigRational &lhs, const BigRational &rhs) { return compare(lhs, rhs) < 0; }
+    friend bool operator<=(const BigRational &lhs, const BigRational &rhs) { return compare(lhs, rhs) <= 0; }
+    friend bool operator>(const BigRational &lhs, const BigRational &rhs) { return compare(lhs, rhs) > 0; }
+    friend bool operator>=(const BigRational &lhs, const BigRational &rhs) { return compare(lhs, rhs) >= 0; }
+
+    // Reduced "p/q", or "p" for integers
+    string toString() const
+    {
+        normalize();
+        if (den == BigInt(1))
+            return num.toString();
+        return num.toString() + "/" + den.toString();
+    }
+
+    friend ostream &operator<<(ostream &os, const BigRational &value)
+    {
+        os << value.toString();
+        return os;
+    }
+
+    friend istream &operator>>(istream &is, BigRational &value)
+    {
+        string str;
+        is >> str;
+        value = BigRational(str);
+        return is;
+    }
+};
+
+// ==================== DECIMAL FIXED POINT ====================
+// BigDecimal is an unscaled BigInt with a decimal scale:
+// value = unscaled * 10^-scale. Since BigInt stores decimal digits,
+// rescaling by powers of ten never divides: raising the scale appends
+// zeros, and lowering it drops digits and rounds by inspecting the
+// dropped digits only.
+
+enum RoundingMode
+{
+    ROUND_HALF_EVEN, // banker's rounding
+    ROUND_HALF_UP,   // ties away from zero
+    ROUND_HALF_DOWN, // ties toward zero
+    ROUND_UP,        // away from zero
+    ROUND_DOWN,      // toward zero (truncate)
+    ROUND_CEILING,   // toward +infinity
+    ROUND_FLOOR      // toward -infinity
+};
+
+// Whether dropping digits must bump the truncated magnitude by one.
+// first is the most significant dropped digit, restNonZero whether any
+// later dropped digit is non-zero.
+static bool roundsAway(RoundingMode mode, bool negative, int first, bool restNonZero, bool truncatedOdd)
+{
+    if (first == 0 && !restNonZero)
+        return false; // exact
+    switch (mode)
+    {
+    case ROUND_UP:
+        return true;
+    case ROUND_DOWN:
+        return false;
+    case ROUND_CEILING:
+        return !negative;
+    case ROUND_FLOOR:
+        return negative;
+    default:
+        break;
+    }
+    if (first != 5 || restNonZero)
+        return first >= 5;
+    if (mode == ROUND_HALF_UP)
+        return true;
+    if (mode == ROUND_HALF_DOWN)
+        return false;
+    return truncatedOdd; // half-even
+}
+
+// value / 10^k rounded with mode, reading only the dropped digits
+static BigInt dropDigits(const BigInt &value, uint64_t k, RoundingMode mode)
+{
+    if (k == 0)
+        return value;
+    const string digits = value.getNumber();
+    size_t len = digits.size();
+    int first = 0;
+    bool restNonZero = false;
+    size_t restStart = 0;
+    if (k <= len)
+    {
+        first = digits[len - k] - '0';
+        restStart = len - k + 1;
+    }
+    for (size_t i = restStart; i < len && !restNonZero; i++)
+        restNonZero = digits[i] != '0';
+
+    BigInt truncated = value;
+    truncated.shiftDigitsRight(k);
+    bool negative = value.getIsNegative();
+    if (roundsAway(mode, negative, first, restNonZero, !truncated.isEven()))
+    {
+        if (negative)
+            truncated -= 1;
+        else
+            truncated += 1;
+    }
+    return truncated;
+}
+
+class BigDecimal
+{
+    BigInt unscaled;
+    int64_t scale;
+
+    // Unscaled value re-expressed at a higher scale (exact)
+    BigInt unscaledAt(int64_t targetScale) const
+    {
+        BigInt result = unscaled;
+        result.shiftDigitsLeft(targetScale - scale);
+        return result;
+    }
+
+public:
+    // Default constructor - zero with scale 0
+    BigDecimal() : unscaled(0), scale(0) {}
+
+    BigDecimal(const BigInt &unscaledValue, int64_t valueScale = 0) : unscaled(unscaledValue), scale(valueScale) {}
+
+    BigDecimal(int64_t value) : unscaled(value), scale(0) {}
+
+    // Constructor from "123", "-0.050", "+12.5"; the scale is the number
+    // of digits after the point
+    BigDecimal(const string &str) : BigDecimal()
+    {
+        size_t point = str.find('.');
+        if (point == string::npos)
+        {
+            unscaled = BigInt(str);
+            return;
+        }
+        string fraction = str.substr(point + 1);
+        if (fraction.empty() || fraction.find_first_not_of("0123456789") != string::npos)
+        {
+            throw invalid_argument("Invalid decimal string: " + str);
+        }
+        string whole = str.substr(0, point);
+        bool sign = !whole.empty() && (whole[0] == '-' || whole[0] == '+');
+        if (whole.size() == (sign ? 1u : 0u))
+        {
+            whole += "0"; // ".5" and "-.5"
+        }
+        unscaled = BigInt(whole + fraction);
+        scale = fraction.size();
+    }
+
+    const BigInt &unscaledValue() const
+    {
+        return unscaled;
+    }
+
+    int64_t getScale() const
+    {
+        return scale;
+    }
+
+    // Same value at a new scale; lowering the scale rounds with mode
+    BigDecimal setScale(int64_t newScale, RoundingMode mode = ROUND_HALF_EVEN) const
+    {
+        if (newScale >= scale)
+        {
+            return BigDecimal(unscaledAt(newScale), newScale);
+        }
+        return BigDecimal(dropDigits(unscaled, scale - newScale, mode), newScale);
+    }
+
+    // Lowest scale that still represents the value exactly
+    BigDecimal stripTrailingZeros() const
+    {
+        if (unscaled.isZero())
+            return BigDecimal();
+        const string digits = unscaled.getNumber();
+        size_t zeros = digits.size() - 1 - digits.find_last_not_of('0');
+        BigDecimal result = *this;
+        result.unscaled.shiftDigitsRight(zeros);
+        result.scale -= zeros;
+        return result;
+    }
+
+    int sign() const
+    {
+        return unscaled.isZero() ? 0 : (unscaled.getIsNegative() ? -1 : 1);
+    }
+
+    BigDecimal operator-() const
+    {
+        return BigDecimal(-unscaled, scale);
+    }
+
+    // Sums and differences take the larger scale and are exact
+    friend BigDecimal operator+(const BigDecimal &lhs, const BigDecimal &rhs)
+    {
+        int64_t s = max(lhs.scale, rhs.scale);
+        return BigDecimal(lhs.unscaledAt(s) + rhs.unscaledAt(s), s);
+    }
+
+    friend BigDecimal operator-(const BigDecimal &lhs, const BigDecimal &rhs)
+    {
+        int64_t s = max(lhs.scale, rhs.scale);
+        return BigDecimal(lhs.unscaledAt(s) - rhs.unscaledAt(s), s);
+    }
+
+    // Products are exact with scale lhs.scale + rhs.scale
+    friend BigDecimal operator*(const BigDecimal &lhs, const BigDecimal &rhs)
+    {
+        return BigDecimal(lhs.unscaled * rhs.unscaled, lhs.scale + rhs.scale);
+    }
+
+    BigDecimal &operator+=(const BigDecimal &other)
+    {
+        *this = *this + other;
+        return *this;
+    }
+
+    BigDecimal &operator-=(const BigDecimal &other)
+    {
+        *this = *this - other;
+        return *this;
+    }
+
+    BigDecimal &operator*=(const BigDecimal &other)
+    {
+        *this = *this * other;
+        return *this;
+    }
+
+    // Quotient at the requested scale, rounded with mode. One extra digit
+    // is computed and the remainder's sign decides ties, so the single
+    // division is exact about which side of the half the result lies.
+    BigDecimal divide(const BigDecimal &divisor, int64_t resultScale, RoundingMode mode = ROUND_HALF_EVEN) const
+    {
+        if (divisor.unscaled.isZero())
+        {
+            throw runtime_error("Division by zero");
+        }
+        // (u1 / 10^s1) / (u2 / 10^s2) at scale r  ->  u1 * 10^(r + 1 + s2 - s1) / u2, then drop one digit
+        int64_t shift = resultScale + 1 + divisor.scale - scale;
+        BigInt numerator = unscaled, denominator = divisor.unscaled;
+        if (shift >= 0)
+            numerator.shiftDigitsLeft(shift);
+        else
+            denominator.shiftDigitsLeft(-shift);
+        BigInt quotient = numerator / denominator;
+        if (!(numerator - quotient * denominator).isZero())
+        {
+            // Inexact: append a sticky digit so "exactly half" cannot be faked
+            bool negative = numerator.getIsNegative() != denominator.getIsNegative();
+            quotient.shiftDigitsLeft(1);
+            if (quotient.isZero())
+                quotient = BigInt(negative ? -1 : 1);
+            else
+                quotient += negative ? -1 : 1;
+            return BigDecimal(dropDigits(quotient, 2, mode), resultScale);
+        }
+        return BigDecimal(dropDigits(quotient, 1, mode), resultScale);
+    }
+
+    // Three-way comparison: one BigInt::compare after bringing the lower
+    // scale up to the higher one
+    static int compare(const BigDecimal &lhs, const BigDecimal &rhs)
+    {
+        if (lhs.scale == rhs.scale)
+            return lhs.unscaled.compare(rhs.unscaled);
+        if (lhs.scale < rhs.scale)
+            return lhs.unscaledAt(rhs.scale).compare(rhs.unscaled);
+        return lhs.unscaled.compare(rhs.unscaledAt(lhs.scale));
+    }
+
+    // Numeric equality: 1.50 == 1.5
+    friend bool operator==(const BigDecimal &lhs, const BigDecimal &rhs) { return compare(lhs, rhs) == 0; }
+    friend bool operator!=(const BigDecimal &lhs, const BigDecimal &rhs) { return compare(lhs, rhs) != 0; }
+    friend bool operator<(const BigDecimal &lhs, const BigDecimal &rhs) { return compare(lhs, rhs) < 0; }
+    friend bool operator<=(const BigDecimal &lhs, const BigDecimal &rhs) { return compare(lhs, rhs) <= 0; }
+    friend bool operator>(const BigDecimal &lhs, const BigDecimal &rhs) { return compare(lhs, rhs) > 0; }
+    friend bool operator>=(const BigDecimal &lhs, const BigDecimal &rhs) { return compare(lhs, rhs) >= 0; }
+
+    // Plain notation with exactly `scale` fractional digits
+    string toString() const
+    {
+        string digits = unscaled.getNumber();
+        string sign = unscaled.getIsNegative() ? "-" : "";
+        if (scale <= 0)
+        {
+            return sign + (unscaled.isZero() ? digits : digits + string(-scale, '0'));
+        }
+        if (digits.size() <= (size_t)scale)
+        {
+            digits.insert(0, scale + 1 - digits.size(), '0');
+        }
+        digits.insert(digits.size() - scale, ".");
+        return sign + digits;
+    }
+
+    friend ostream &operator<<(ostream &os, const BigDecimal &value)
+    {
+        os << value.toString();
+        return os;
+    }
+
+    friend istream &operator>>(istream &is, BigDecimal &value)
+    {
+        string str;
+        is >> str;
+        value = BigDecimal(str);
+        return is;
+    }
+};
+
+// Exact sum of a whole column. Values sharing a scale (the usual ledger
+// case) are added as plain BigInts with no alignment at all; each
+// per-scale subtotal is shifted to the common scale once at the end.
+BigDecimal batchSum(const vector<BigDecimal> &values)
+{
+    TITAN_TRACE_SCOPE("BigDecimal::batchSum");
+    vector<pair<int64_t, BigInt>> subtotals; // few distinct scales in practice
+    for (const BigDecimal &value : values)
+    {
+        size_t i = 0;
+        while (i < subtotals.size() && subtotals[i].first != value.getScale())
+            ++i;
+        if (i == subtotals.size())
+            subtotals.push_back({value.getScale(), BigInt(0)});
+        subtotals[i].second += value.unscaledValue();
+    }
+    int64_t scale = subtotals.empty() ? 0 : subtotals[0].first;
+    for (const pair<int64_t, BigInt> &subtotal : subtotals)
+        scale = max(scale, subtotal.first);
+    BigInt total(0);
+    for (pair<int64_t, BigInt> &subtotal : subtotals)
+    {
+        subtotal.second.shiftDigitsLeft(scale - subtotal.first);
+        total += subtotal.second;
+    }
+    return BigDecimal(total, scale);
+}
+
+// ==================== NEWTON DIVISION ====================
+// Long division costs one trial subtraction pass per quotient digit. For
+// large operands the quotient is instead read off a reciprocal computed
+// with Newton's iteration r += r(1 - d*r), which doubles the number of
+// correct digits per step, so a division costs a small multiple of one
+// full-size multiplication.
+
+// R ~ 10^k / d for d > 0 and k >= digits(d), within a few units
+static BigInt reciprocalScaled(const BigInt &d, size_t k)
+{
+    size_t n = d.digitCount();
+    size_t p = k - n; // R has p or p + 1 digits
+    if (n > p + 4)
+    {
+        // Digits of d below its top p + 4 cannot reach the result
+        BigInt top = d;
+        top.shiftDigitsRight(n - p - 4);
+        return reciprocalScaled(top, k - (n - p - 4));
+    }
+    if (p <= 15)
+    {
+        long double value = (long double)smallMagnitude(d); // n <= 19 here
+        return BigInt((int64_t)(powl(10.0L, k) / value));
+    }
+
+    size_t h = p / 2 + 2; // two guard digits absorb truncation error
+    BigInt r = reciprocalScaled(d, n + h);
+    r.shiftDigitsLeft(p - h); // 10^(n+h)/d -> 10^k/d
+
+    BigInt one(1);
+    one.shiftDigitsLeft(k);
+    BigInt correction = r * (one - d * r);
+    correction.shiftDigitsRight(k);
+    return r + correction;
+}
+
+// Floor quotient and remainder of a >= 0 by d > 0, given a reciprocal
+// ~ 10^k / d with k > digits(a)
+static pair<BigInt, BigInt> divmodByReciprocal(const BigInt &a, const BigInt &d, const BigInt &reciprocal, size_t k)
+{
+    BigInt q = a * reciprocal;
+    q.shiftDigitsRight(k);
+
+    // The estimate is off by at most a few units; settle it exactly
+    BigInt r = a - q * d;
+    while (r.getIsNegative())
+    {
+        --q;
+        r += d;
+    }
+    while (r >= d)
+    {
+        ++q;
+        r -= d;
+    }
+    return {q, r};
+}
+
+// Floor quotient and remainder of a >= 0 by d > 0
+static pair<BigInt, BigInt> divmodNewton(const BigInt &a, const BigInt &d)
+{
+    if (a < d)
+    {
+        return {BigInt(0), a};
+    }
+    size_t k = a.digitCount() + 1;
+    return divmodByReciprocal(a, d, reciprocalScaled(d, k), k);
+}
+
+// ==================== DIVISORS ====================
+// A Divisor is a divisor prepared for repeated use. Divisors that fit a
+// machine word go straight to the scalar paths; larger ones keep a Newton
+// reciprocal 10^K / |d|, computed once for dividends of up to K - 1
+// digits and grown (by recomputing at twice the size) when a longer one
+// arrives. A shorter dividend uses the reciprocal's leading digits, so a
+// division costs about two multiplications and no Newton iteration.
+// Divisors are safe to share between threads.
+
+class Divisor
+{
+    BigInt value;            // as given, sign included
+    BigInt magnitude;
+    uint64_t small = 0;      // |d| when it takes the scalar path, else 0
+    mutable mutex lock;      // guards reciprocal and scale
+    mutable BigInt reciprocal; // ~ 10^scale / |d|
+    mutable size_t scale = 0;
+
+    // A reciprocal good for dividends of `digits` digits, and its scale
+    pair<BigInt, size_t> reciprocalFor(size_t digits) const
+    {
+        size_t k = max(digits, magnitude.digitCount()) + 1;
+        lock_guard<mutex> guard(lock);
+        if (k > scale)
+        {
+            scale = max(k, 2 * scale);
+            reciprocal = reciprocalScaled(magnitude, scale);
+        }
+        // floor(R / 10^(scale - k)) is still within a unit of 10^k / |d|
+        BigInt leading = reciprocal;
+        leading.shiftDigitsRight(scale - k);
+        return {leading, k};
+    }
+
+public:
+    // Prepares d for dividends of up to expectedDigits digits (longer ones
+    // still work); throws for zero
+    explicit Divisor(const BigInt &d, size_t expectedDigits = 0) : value(d), magnitude(d)
+    {
+        if (d.isZero())
+        {
+            throw runtime_error("Division by zero");
+        }
+        magnitude.setIsNegative(false);
+        if (!magnitude.magnitudeToUint64(small) || small > UINT64_MAX / 10)
+        {
+            small = 0;
+            reciprocalFor(max(expectedDigits, 2 * magnitude.digitCount()));
+        }
+    }
+
+    const BigInt &getValue() const
+    {
+        return value;
+    }
+
+    // Truncated quotient and remainder with the signs of operator/ and operator%
+    pair<BigInt, BigInt> divmod(const BigInt &a) const
+    {
+        pair<BigInt, BigInt> qr;
+        if (small != 0)
+        {
+            qr.first = a;
+            qr.second = BigInt((int64_t)qr.first.divideMagnitudeSmall(small)); // small <= UINT64_MAX / 10
+        }
+        else if (a.compareMagnitude(magnitude) < 0)
+        {
+            qr = {BigInt(0), a};
+        }
+        else
+        {
+            BigInt dividend = a;
+            dividend.setIsNegative(false);
+            pair<BigInt, size_t> r = reciprocalFor(dividend.digitCount());
+            qr = divmodByReciprocal(dividend, magnitude, r.first, r.second);
+        }
+        qr.first.setIsNegative(a.getIsNegative() != value.getIsNegative() && !qr.first.isZero());
+        qr.second.setIsNegative(a.getIsNegative() && !qr.second.isZero());
+        return qr;
+    }
+};
+
+BigInt operator/(const BigInt &lhs, const Divisor &rhs)
+{
+    TITAN_TRACE_SCOPE("BigInt::div");
+    return rhs.divmod(lhs).first;
+}
+
+BigInt operator%(const BigInt &lhs, const Divisor &rhs)
+{
+    TITAN_TRACE_SCOPE("BigInt::mod");
+    return rhs.divmod(lhs).second;
+}
+
+pair<BigInt, BigInt> divmod(const BigInt &lhs, const Divisor &rhs)
+{
+    return rhs.divmod(lhs);
+}
+
+// Quotient and remainder in one call, as operator/ and operator%
+pair<BigInt, BigInt> divmod(const BigInt &lhs, const BigInt &rhs)
+{
+    return Divisor(rhs, lhs.digitCount()).divmod(lhs);
+}
+
+// base^exp mod m for exp >= 0, every reduction reusing m's reciprocal;
+// the result is in [0, |m|)
+BigInt powMod(BigInt base, BigInt exp, const Divisor &m)
+{
+    TITAN_TRACE_SCOPE("powMod");
+    if (exp.getIsNegative())
+    {
+        throw runtime_error("Negative exponent in powMod");
+    }
+    BigInt modulus = m.getValue();
+    modulus.setIsNegative(false);
+    auto reduce = [&](const BigInt &x) {
+        BigInt r = x % m;
+        return r.getIsNegative() ? r + modulus : r;
+    };
+    BigInt result = reduce(BigInt(1));
+    base = reduce(base);
+    while (!exp.isZero())
+    {
+        if (!exp.isEven())
+            result = reduce(result * base);
+        base = reduce(base * base);
+        exp /= 2;
+    }
+    return result;
+}
+
+// Bounded LRU cache of prepared divisors keyed by the divisor's hash, so
+// code that sees the same few divisors again and again prepares each once.
+// Safe to use from several threads.
+class DivisorCache
+{
+    typedef list<shared_ptr<const Divisor>> Entries;
+    size_t capacity;
+    mutex lock;
+    Entries entries; // most recently used first
+    unordered_multimap<size_t, Entries::iterator> index;
+
+public:
+    explicit DivisorCache(size_t maxEntries) : capacity(max<size_t>(maxEntries, 1)) {}
+
+    // The prepared divisor for d, built on a miss; throws for zero
+    shared_ptr<const Divisor> get(const BigInt &d)
+    {
+        size_t h = d.hash();
+        {
+            lock_guard<mutex> guard(lock);
+            auto range = index.equal_range(h);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if ((*it->second)->getValue() == d)
+                {
+                    entries.splice(entries.begin(), entries, it->second);
+                    return entries.front();
+                }
+            }
+        }
+
+        // Prepared outside the lock; a racing miss on the same d only
+        // costs a duplicate entry that ages out
+        shared_ptr<const Divisor> prepared = make_shared<const Divisor>(d);
+        lock_guard<mutex> guard(lock);
+        entries.push_front(prepared);
+        index.emplace(h, entries.begin());
+        if (entries.size() > capacity)
+        {
+            const BigInt &oldest = entries.back()->getValue();
+            auto range = index.equal_range(oldest.hash());
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second == prev(entries.end()))
+                {
+                    index.erase(it);
+                    break;
+                }
+            }
+            entries.pop_back();
+        }
+        return prepared;
+    }
+
+    size_t size()
+    {
+        lock_guard<mutex> guard(lock);
+        return entries.size();
+    }
+
+    void clear()
+    {
+        lock_guard<mutex> guard(lock);
+        index.clear();
+        entries.clear();
+    }
+};
+
+// Process-wide divisor cache (64 entries)
+DivisorCache &divisorCache()
+{
+    static DivisorCache cache(64);
+    return cache;
+}
+
+// ==================== FLOATING POINT ====================
+// BigFloat is a BigInt mantissa with a decimal exponent and a precision
+// in significant digits: value = mantissa * 10^exponent. The radix
+// matches the digit storage, so rounding to the precision drops digits
+// instead of multiplying by a power of two. +, -, *, / and sqrt are
+// correctly rounded (half-even): each is computed exactly, or with a
+// sticky digit standing in for a non-zero remainder, and rounded once.
+// Results take the larger precision of their operands.
+
+class BigFloat
+{
+    BigInt mantissa;   // at most `precision` digits, no trailing zeros
+    int64_t exponent;  // 0 when the value is zero
+    size_t precision;
+
+    static size_t &defaultPrecisionSlot()
+    {
+        static size_t digits = 50;
+        return digits;
+    }
+
+    // m * 10^e rounded to prec digits. sticky is the sign of a remainder
+    // lying below the last digit of m (0 when m is exact); it becomes one
+    // extra digit so a truncated tie is never taken for an exact one.
+    static BigFloat rounded(BigInt m, int64_t e, size_t prec, int sticky = 0)
+    {
+        if (sticky != 0)
+        {
+            m.shiftDigitsLeft(1);
+            m += sticky;
+            --e;
+        }
+        size_t digits = m.digitCount();
+        if (digits > prec)
+        {
+            m = dropDigits(m, digits - prec, ROUND_HALF_EVEN);
+            e += digits - prec;
+        }
+
+        BigFloat result;
+        result.precision = prec;
+        if (m.isZero())
+        {
+            return result;
+        }
+        // Strip trailing zeros, which also absorbs a carry to 10^prec
+        const string text = m.getNumber();
+        size_t zeros = text.size() - 1 - text.find_last_not_of('0');
+        m.shiftDigitsRight(zeros);
+        result.mantissa = m;
+        result.exponent = e + zeros;
+        return result;
+    }
+
+    // Correctly rounded sum. An operand lying wholly below the other's
+    // last kept digit only matters through its sign, so it is cut to a
+    // sticky digit instead of being aligned digit for digit: 1e100 + 1e-100
+    // costs no more than 1e100 + 1.
+    static BigFloat add(const BigFloat &lhs, const BigFloat &rhs)
+    {
+        size_t prec = max(lhs.precision, rhs.precision);
+        if (lhs.isZero())
+            return rounded(rhs.mantissa, rhs.exponent, prec);
+        if (rhs.isZero())
+            return rounded(lhs.mantissa, lhs.exponent, prec);
+
+        bool lhsLarger = lhs.topExponent() >= rhs.topExponent();
+        const BigFloat &big = lhsLarger ? lhs : rhs;
+        const BigFloat &small = lhsLarger ? rhs : lhs;
+        BigInt low = small.mantissa;
+        int64_t lowExponent = small.exponent;
+        int sticky = 0;
+
+        // With the tops two or more digits apart at most one digit cancels,
+        // so the result keeps digits down to at least cut + 2
+        int64_t cut = min(big.topExponent() - (int64_t)prec - 3, big.exponent);
+        if (small.topExponent() <= big.topExponent() - 2 && lowExponent < cut)
+        {
+            // Mantissas end in a non-zero digit, so the cut is inexact
+            sticky = low.getIsNegative() ? -1 : 1;
+            low.shiftDigitsRight(cut - lowExponent);
+            lowExponent = cut;
+        }
+
+        int64_t e = min(big.exponent, lowExponent);
+        BigInt high = big.mantissa;
+        high.shiftDigitsLeft(big.exponent - e);
+        low.shiftDigitsLeft(lowExponent - e);
+        return rounded(high + low, e, prec, sticky);
+    }
+
+public:
+    // Default constructor - zero at the default precision
+    BigFloat() : mantissa(0), exponent(0), precision(defaultPrecision()) {}
+
+    BigFloat(const BigInt &value, size_t digits = defaultPrecision()) : BigFloat(rounded(value, 0, digits)) {}
+
+    BigFloat(int64_t value, size_t digits = defaultPrecision()) : BigFloat(BigInt(value), digits) {}
+
+    // mantissa * 10^exponent rounded to digits
+    BigFloat(const BigInt &mantissaValue, int64_t exponentValue, size_t digits)
+        : BigFloat(rounded(mantissaValue, exponentValue, digits)) {}
+
+    // Constructor from "3.14", "-1.5e-7", "2E10", ".5"
+    BigFloat(const string &str, size_t digits = defaultPrecision()) : BigFloat()
+    {
+        string body = str;
+        int64_t e = 0;
+        size_t mark = str.find_first_of("eE");
+        if (mark != string::npos)
+        {
+            string power = str.substr(mark + 1);
+            size_t used = 0;
+            if (!power.empty() && power.find_first_not_of("+-0123456789") == string::npos)
+            {
+                try
+                {
+                    e = stoll(power, &used);
+                }
+                catch (const logic_error &)
+                {
+                    used = 0;
+                }
+            }
+            if (used == 0 || used != power.size())
+            {
+                throw invalid_argument("Invalid float string: " + str);
+            }
+            body = str.substr(0, mark);
+        }
+        size_t point = body.find('.');
+        if (point != string::npos)
+        {
+            string fraction = body.substr(point + 1);
+            if (fraction.find_first_not_of("0123456789") != string::npos)
+            {
+                throw invalid_argument("Invalid float string: " + str);
+            }
+            body = body.substr(0, point);
+            bool sign = !body.empty() && (body[0] == '-' || body[0] == '+');
+            if (body.size() == (sign ? 1u : 0u) && fraction.empty())
+            {
+                throw invalid_argument("Invalid float string: " + str);
+            }
+            body += fraction;
+            e -= fraction.size();
+        }
+        *this = rounded(BigInt(body), e, digits);
+    }
+
+    // Precision used for values built without an explicit one
+    static size_t defaultPrecision()
+    {
+        return defaultPrecisionSlot();
+    }
+
+    static void setDefaultPrecision(size_t digits)
+    {
+        if (digits == 0)
+        {
+            throw invalid_argument("Precision must be at least one digit");
+        }
+        defaultPrecisionSlot() = digits;
+    }
+
+    const BigInt &mantissaValue() const
+    {
+        return mantissa;
+    }
+
+    int64_t getExponent() const
+    {
+        return exponent;
+    }
+
+    size_t getPrecision() const
+    {
+        return precision;
+    }
+
+    // t with 10^(t-1) <= |value| < 10^t (0 for zero)
+    int64_t topExponent() const
+    {
+        return isZero() ? 0 : exponent + (int64_t)mantissa.digitCount();
+    }
+
+    // Same value at another precision; narrowing rounds half-even
+    BigFloat withPrecision(size_t digits) const
+    {
+        return rounded(mantissa, exponent, digits);
+    }
+
+    bool isZero() const
+    {
+        return mantissa.isZero();
+    }
+
+    int sign() const
+    {
+        return mantissa.isZero() ? 0 : (mantissa.getIsNegative() ? -1 : 1);
+    }
+
+    BigFloat operator-() const
+    {
+        BigFloat result = *this;
+        result.mantissa = -mantissa;
+        return result;
+    }
+
+    friend BigFloat operator+(const BigFloat &lhs, const BigFloat &rhs)
+    {
+        TITAN_TRACE_SCOPE("BigFloat::add");
+        return add(lhs, rhs);
+    }
+
+    friend BigFloat operator-(const BigFloat &lhs, const BigFloat &rhs)
+    {
+        TITAN_TRACE_SCOPE("BigFloat::add");
+        return add(lhs, -rhs);
+    }
+
+    // The exact product rounded once
+    friend BigFloat operator*(const BigFloat &lhs, const BigFloat &rhs)
+    {
+        TITAN_TRACE_SCOPE("BigFloat::mul");
+        return rounded(lhs.mantissa * rhs.mantissa, lhs.exponent + rhs.exponent, max(lhs.precision, rhs.precision));
+    }
+
+    // Quotient with two digits beyond the precision plus a sticky digit
+    // for the remainder, from one Newton division of the mantissas
+    friend BigFloat operator/(const BigFloat &lhs, const BigFloat &rhs)
+    {
+        TITAN_TRACE_SCOPE("BigFloat::div");
+        if (rhs.isZero())
+        {
+            throw runtime_error("Division by zero");
+        }
+        size_t prec = max(lhs.precision, rhs.precision);
+        if (lhs.isZero())
+        {
+            return rounded(BigInt(0), 0, prec);
+        }
+        int64_t shift = (int64_t)prec + 2 + (int64_t)rhs.mantissa.digitCount() - (int64_t)lhs.mantissa.digitCount();
+        shift = max<int64_t>(shift, 0);
+        BigInt numerator = lhs.mantissa, denominator = rhs.mantissa;
+        numerator.setIsNegative(false);
+        denominator.setIsNegative(false);
+        numerator.shiftDigitsLeft(shift);
+
+        pair<BigInt, BigInt> qr = divmodNewton(numerator, denominator);
+        bool negative = lhs.mantissa.getIsNegative() != rhs.mantissa.getIsNegative();
+        int sticky = qr.second.isZero() ? 0 : (negative ? -1 : 1);
+        BigInt quotient = negative ? -qr.first : qr.first;
+        return rounded(quotient, lhs.exponent - rhs.exponent - shift, prec, sticky);
+    }
+
+    // Root with two digits beyond the precision plus a sticky digit,
+    // from the Newton integer square root of the scaled mantissa
+    friend BigFloat sqrt(const BigFloat &x)
+    {
+        TITAN_TRACE_SCOPE("BigFloat::sqrt");
+        if (x.sign() < 0)
+        {
+            throw runtime_error("Square root of negative number");
+        }
+        if (x.isZero())
+        {
+            return x;
+        }
+        int64_t shift = 2 * ((int64_t)x.precision + 2) - (int64_t)x.mantissa.digitCount();
+        shift = max<int64_t>(shift, 0);
+        if ((x.exponent - shift) % 2 != 0)
+        {
+            ++shift; // keep the remaining power of ten even
+        }
+        BigInt scaled = x.mantissa;
+        scaled.shiftDigitsLeft(shift);
+        BigInt root = isqrt(scaled);
+        int sticky = root * root == scaled ? 0 : 1;
+        return rounded(root, (x.exponent - shift) / 2, x.precision, sticky);
+    }
+
+    BigFloat &operator+=(const BigFloat &other)
+    {
+        *this = *this + other;
+        return *this;
+    }
+
+    BigFloat &operator-=(const BigFloat &other)
+    {
+        *this = *this - other;
+        return *this;
+    }
+
+    BigFloat &operator*=(const BigFloat &other)
+    {
+        *this = *this * other;
+        return *this;
+    }
+
+    BigFloat &operator/=(const BigFloat &other)
+    {
+        *this = *this / other;
+        return *this;
+    }
+
+    // Three-way comparison: signs, then magnitudes by top exponent, and
+    // only then the aligned mantissas
+    static int compare(const BigFloat &lhs, const BigFloat &rhs)
+    {
+        int ls = lhs.sign(), rs = rhs.sign();
+        if (ls != rs)
+            return ls < rs ? -1 : 1;
+        if (ls == 0)
+            return 0;
+        int64_t lt = lhs.topExponent(), rt = rhs.topExponent();
+        if (lt != rt)
+            return (lt < rt) == (ls > 0) ? -1 : 1;
+        int64_t e = min(lhs.exponent, rhs.exponent);
+        BigInt a = lhs.mantissa, b = rhs.mantissa;
+        a.shiftDigitsLeft(lhs.exponent - e);
+        b.shiftDigitsLeft(rhs.exponent - e);
+        if (a == b)
+            return 0;
+        return a < b ? -1 : 1;
+    }
+
+    // Numeric equality, regardless of precision
+    friend bool operator==(const BigFloat &lhs, const BigFloat &rhs) { return compare(lhs, rhs) == 0; }
+    friend bool operator!=(const BigFloat &lhs, const BigFloat &rhs) { return compare(lhs, rhs) != 0; }
+    friend bool operator<(const BigFloat &lhs, const BigFloat &rhs) { return compare(lhs, rhs) < 0; }
+    friend bool operator<=(const BigFloat &lhs, const BigFloat &rhs) { return compare(lhs, rhs) <= 0; }
+    friend bool operator>(const BigFloat &lhs, const BigFloat &rhs) { return compare(lhs, rhs) > 0; }
+    friend bool operator>=(const BigFloat &lhs, const BigFloat &rhs) { return compare(lhs, rhs) >= 0; }
+
+    // Plain notation while the point falls near the significant digits,
+    // scientific notation ("1.5e-20") otherwise
+    string toString() const
+    {
+        if (isZero())
+            return "0";
+        string digits = mantissa.getNumber();
+        string sign = mantissa.getIsNegative() ? "-" : "";
+        int64_t point = (int64_t)digits.size() + exponent; // digits before the point
+        if (exponent >= 0 && point <= (int64_t)max<size_t>(precision, 21))
+            return sign + digits + string(exponent, '0');
+        if (exponent < 0 && point > 0)
+            return sign + digits.substr(0, point) + "." + digits.substr(point);
+        if (point <= 0 && point > -6)
+            return sign + "0." + string(-point, '0') + digits;
+        string scientific = digits.substr(0, 1);
+        if (digits.size() > 1)
+            scientific += "." + digits.substr(1);
+        return sign + scientific + "e" + to_string(point - 1);
+    }
+
+    friend ostream &operator<<(ostream &os, const BigFloat &value)
+    {
+        os << value.toString();
+        return os;
+    }
+
+    friend istream &operator>>(istream &is, BigFloat &value)
+    {
+        string str;
+        is >> str;
+        value = BigFloat(str);
+        return is;
+    }
+};
+
+// Integer triple (P, Q, T) of a binary-split series: the terms [a, b)
+// sum to T / Q and P is the product of their numerator factors. Merging
+// two halves is three multiplications, so a whole series costs a few
+// large multiplications instead of one division per term.
+struct SeriesSplit
+{
+    BigInt P, Q, T;
+};
+
+static SeriesSplit mergeSplit(const SeriesSplit &left, const SeriesSplit &right)
+{
+    return {left.P * right.P, left.Q * right.Q, left.T * right.Q + left.P * right.T};
+}
+
+// Terms of exp(p / q) = sum (p/q)^n / n!
+static SeriesSplit expSplit(const BigInt &p, const BigInt &q, uint64_t a, uint64_t b)
+{
+    if (b - a == 1)
+    {
+        if (a == 0)
+            return {BigInt(1), BigInt(1), BigInt(1)};
+        return {p, q * a, p};
+    }
+    uint64_t m = a + (b - a) / 2;
+    return mergeSplit(expSplit(p, q, a, m), expSplit(p, q, m, b));
+}
+
+// Terms of the Chudnovsky series for 1 / pi, about 14 digits each
+static SeriesSplit chudnovskySplit(uint64_t a, uint64_t b)
+{
+    if (b - a == 1)
+    {
+        if (a == 0)
+            return {BigInt(1), BigInt(1), BigInt(13591409)};
+        BigInt P = BigInt((int64_t)(6 * a - 5)) * (2 * a - 1) * (6 * a - 1);
+        BigInt Q = BigInt((int64_t)a) * a * a * (uint64_t)10939058860032000ULL; // 640320^3 / 24
+        BigInt T = P * (13591409 + 545140134 * a);
+        return {P, Q, a % 2 ? -T : T};
+    }
+    uint64_t m = a + (b - a) / 2;
+    return mergeSplit(chudnovskySplit(a, m), chudnovskySplit(m, b));
+}
+
+// pi to the requested number of significant digits
+BigFloat pi(size_t digits = BigFloat::defaultPrecision())
+{
+    TITAN_TRACE_SCOPE("BigFloat::pi");
+    size_t wp = digits + 10;
+    SeriesSplit s = chudnovskySplit(0, wp / 14 + 2);
+    BigFloat scale = BigFloat(426880, wp) * sqrt(BigFloat(10005, wp));
+    return (BigFloat(s.Q, 0, wp) * scale / BigFloat(s.T, 0, wp)).withPrecision(digits);
+}
+
+// e^x at the precision of x. The argument is halved K times (exactly,
+// as x * 5^K / 10^K) and the result squared K times. The reduced
+// argument is split into digit chunks of doubling length, each summed
+// by binary splitting: a short chunk gives small integers, a long one
+// needs few terms, so every chunk costs about the same.
+BigFloat exp(const BigFloat &x)
+{
+    TITAN_TRACE_SCOPE("BigFloat::exp");
+    size_t prec = x.getPrecision();
+    if (x.isZero())
+    {
+        return BigFloat(1, prec);
+    }
+    int64_t top = x.topExponent();
+    if (top > 15)
+    {
+        throw runtime_error("Exponent argument too large");
+    }
+    // |x| < 10^-(prec + 1): e^x is within half a unit of 1 either side
+    if (top <= -(int64_t)prec - 1)
+    {
+        return BigFloat(1, prec);
+    }
+    size_t halvings = (top > 0 ? (size_t)ceil(top * 3.3219280948873623) : 0) + (size_t)sqrt((double)prec);
+    size_t wp = prec + 10 + (size_t)(halvings * 0.30103) + (top > 0 ? top : 0);
+    BigFloat r(x.mantissaValue() * pow(BigInt(5), halvings), x.getExponent() - (int64_t)halvings, wp);
+
+    BigFloat result(1, wp);
+    if (!r.isZero())
+    {
+        bool negative = r.sign() < 0;
+        size_t fractionDigits = -r.getExponent(); // |r| < 1
+        const string digits = r.mantissaValue().getNumber();
+        size_t leadingZeros = fractionDigits - digits.size();
+        for (size_t start = 0, end = min<size_t>(4, fractionDigits); start < fractionDigits;
+             start = end, end = min(2 * end, fractionDigits))
+        {
+            // Chunks before the first significant digit are all zeros
+            if (end <= leadingZeros)
+                continue;
+            size_t from = max(start, leadingZeros);
+            BigInt p(digits.substr(from - leadingZeros, end - from));
+            if (p.isZero())
+                continue;
+            if (negative)
+                p = -p;
+            BigInt q(1);
+            q.shiftDigitsLeft(end);
+
+            // Enough terms that the next one is below the working precision
+            long double logChunk = (long double)p.digitCount() - (long double)end;
+            long double logTerm = 0;
+            uint64_t terms = 1;
+            while (logTerm > -(long double)(wp + 2))
+            {
+                logTerm += logChunk - log10l((long double)terms);
+                ++terms;
+            }
+            SeriesSplit s = expSplit(p, q, 0, terms);
+            result *= BigFloat(s.T, 0, wp) / BigFloat(s.Q, 0, wp);
+        }
+    }
+    for (size_t i = 0; i < halvings; i++)
+    {
+        result *= result;
+    }
+    return result.withPrecision(prec);
+}
+
+// Natural logarithm at the precision of x, by Halley's iteration
+// y += 2(x - e^y) / (x + e^y), which triples the correct digits per step;
+// each step runs at the precision it can deliver, so the cost is
+// dominated by the final exp.
+BigFloat log(const BigFloat &x)
+{
+    TITAN_TRACE_SCOPE("BigFloat::log");
+    if (x.sign() <= 0)
+    {
+        throw runtime_error("Logarithm of non-positive number");
+    }
+    size_t prec = x.getPrecision();
+    BigFloat distance = x - BigFloat(1, prec);
+    if (distance.isZero())
+    {
+        return BigFloat(0, prec);
+    }
+    // Near 1 the result is small, so its leading zeros need digits too
+    size_t wp = prec + 10 + (size_t)max<int64_t>(-distance.topExponent(), 0);
+
+    // Seed from the leading digits in long double
+    string digits = x.mantissaValue().getNumber();
+    size_t lead = min<size_t>(digits.size(), 18);
+    long double seed = logl(stold(digits.substr(0, lead))) +
+                       (long double)(x.getExponent() + (int64_t)(digits.size() - lead)) * logl(10.0L);
+    BigFloat y(0, wp);
+    if (seed != 0)
+    {
+        int order = (int)floorl(log10l(fabsl(seed)));
+        y = BigFloat(BigInt((int64_t)llroundl(seed * powl(10.0L, 17 - order))), order - 17, wp);
+    }
+
+    for (size_t working = min<size_t>(16, wp);; working = min(3 * working, wp))
+    {
+        BigFloat xs = x.withPrecision(working), ys = y.withPrecision(working);
+        BigFloat ey = exp(ys);
+        y = ys + BigFloat(2, working) * (xs - ey) / (xs + ey);
+        if (working == wp)
+            break;
+    }
+    return y.withPrecision(prec);
+}
+
+// ==================== REMAINDER TREES ====================
+// x mod m_i for many moduli at once. The moduli are multiplied up a
+// product tree, x is reduced modulo the root, and each remainder is
+// pushed down: a node reduces its parent's remainder modulo its own
+// product. Every level costs about one division of x's size, so k
+// remainders cost O(M(n) log k) instead of k divisions of all of x.
+// Levels are split across threads once they are wide enough.
+
+// Runs body(lo, hi) over [0, count), split across threads when every
+// thread gets at least `grain` items
+template <typename Body>
+static void parallelChunks(size_t count, size_t grain, Body body)
+{
+    size_t threads = min<size_t>(max(1u, thread::hardware_concurrency()), count / max<size_t>(grain, 1));
+    if (threads <= 1)
+    {
+        body(0, count);
+        return;
+    }
+    size_t chunk = (count + threads - 1) / threads;
+    vector<future<void>> tasks;
+    for (size_t lo = chunk; lo < count; lo += chunk)
+        tasks.push_back(async(launch::async, body, lo, min(lo + chunk, count)));
+    body(0, chunk);
+    for (future<void> &task : tasks)
+        task.get();
+}
+
+// Nodes per thread at a tree depth (0 = leaves): operands double in size
+// per level, so deep levels split across threads much sooner
+static size_t treeGrain(size_t depth)
+{
+    return max<size_t>(1, 4096 >> min<size_t>(depth, 12));
+}
+
+// levels[0] holds the leaves, each level above the products of adjacent
+// pairs (an odd last node is carried up unchanged), and levels.back()[0]
+// the product of all leaves
+vector<vector<BigInt>> productTreeLevels(const vector<BigInt> &leaves)
+{
+    TITAN_TRACE_SCOPE("productTreeLevels");
+    vector<vector<BigInt>> levels(1, leaves);
+    while (levels.back().size() > 1)
+    {
+        const vector<BigInt> &below = levels.back();
+        vector<BigInt> level((below.size() + 1) / 2);
+        parallelChunks(level.size(), treeGrain(levels.size() - 1), [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++)
+                level[i] = 2 * i + 1 < below.size() ? below[2 * i] * below[2 * i + 1] : below[2 * i];
+        });
+        levels.push_back(move(level));
+    }
+    return levels;
+}
+
+// x mod node (or mod node^2 when squared) for every node of levels[stop]
+// of a product tree built by productTreeLevels; stop = 0 gives the
+// leaves. Remainders follow operator%: they take the sign of x.
+static vector<BigInt> remainderTree(const BigInt &x, const vector<vector<BigInt>> &levels, bool squared,
+                                    bool parallel = true, size_t stop = 0)
+{
+    if (levels.empty() || levels[0].empty())
+    {
+        return {};
+    }
+    const BigInt &root = levels.back()[0];
+    vector<BigInt> current(1, squared ? x % (root * root) : x % root);
+    for (size_t depth = levels.size() - 1; depth-- > stop;)
+    {
+        const vector<BigInt> &nodes = levels[depth];
+        vector<BigInt> next(nodes.size());
+        parallelChunks(nodes.size(), parallel ? treeGrain(depth) : nodes.size(), [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++)
+                next[i] = squared ? current[i / 2] % (nodes[i] * nodes[i]) : current[i / 2] % nodes[i];
+        });
+        current = move(next);
+    }
+    return current;
+}
+
+// x % m for every modulus, sharing the work through a remainder tree
+vector<BigInt> remainders(const BigInt &x, const vector<BigInt> &moduli)
+{
+    TITAN_TRACE_SCOPE("remainders");
+    for (const BigInt &m : moduli)
+    {
+        if (m.isZero())
+        {
+            throw runtime_error("modulus by zero");
+        }
+    }
+    return remainderTree(x, productTreeLevels(moduli), false);
+}
+
+// gcd(n_i, product of all other n_j) for every value (Bernstein's batch
+// GCD): with P the product of all values, z_i = P mod n_i^2 from one
+// remainder tree, and gcd(n_i, z_i / n_i) is the answer. A result above 1
+// exposes a factor shared with some other value, e.g. RSA moduli that
+// reuse a prime.
+vector<BigInt> batchGcd(const vector<BigInt> &values)
+{
+    TITAN_TRACE_SCOPE("batchGcd");
+    for (const BigInt &v : values)
+    {
+        if (v.isZero() || v.getIsNegative())
+        {
+            throw invalid_argument("batchGcd requires positive values");
+        }
+    }
+    if (values.empty())
+    {
+        return {};
+    }
+    vector<vector<BigInt>> levels = productTreeLevels(values);
+    vector<BigInt> result = remainderTree(levels.back()[0], levels, true);
+    parallelChunks(result.size(), 64, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++)
+            result[i] = gcd(values[i], result[i] / values[i]);
+    });
+    return result;
+}
+
+// ==================== RESIDUE NUMBER SYSTEM ====================
+// An RnsInt stores a value as its residues modulo a fixed basis of 31-bit
+// primes. Addition, subtraction and multiplication are then one word
+// operation per prime with no carries between primes, so a long chain of
+// products costs O(k) per step instead of a growing multiplication. The
+// BigInt is rebuilt by the Chinese remainder theorem only when asked for.
+// Values wrap modulo M, the product of the primes: a basis must be sized
+// for the largest intermediate value, not just for the inputs.
+
+// Word operations a thread should get before splitting a loop pays off
+const size_t RNS_PARALLEL_GRAIN = 32768;
+// Values with at least this many digits are converted by a remainder tree;
+// below it the O(k n) word loop is faster than the tree's divisions;
+// tunable (see TUNING)
+size_t RNS_TREE_MIN_DIGITS = 40000;
+// Depth at which the remainder tree hands over to word arithmetic
+// (nodes of 2^depth primes)
+const size_t RNS_TREE_LEAF_DEPTH = 5;
+
+static uint32_t powMod32(uint64_t base, uint64_t exp, uint32_t mod)
+{
+    uint64_t result = 1;
+    base %= mod;
+    for (; exp > 0; exp >>= 1)
+    {
+        if (exp & 1)
+            result = result * base % mod;
+        base = base * base % mod;
+    }
+    return (uint32_t)result;
+}
+
+// Deterministic Miller-Rabin: bases 2, 7 and 61 decide every n < 2^32
+static bool isPrime32(uint32_t n)
+{
+    if (n < 2)
+        return false;
+    for (uint32_t p : {2u, 3u, 5u, 7u, 61u})
+        if (n % p == 0)
+            return n == p;
+    uint32_t d = n - 1;
+    int s = 0;
+    while (d % 2 == 0)
+    {
+        d /= 2;
+        ++s;
+    }
+    for (uint32_t a : {2u, 7u, 61u})
+    {
+        uint64_t x = powMod32(a, d, n);
+        if (x == 1 || x == n - 1)
+            continue;
+        int i = 1;
+        for (; i < s; i++)
+        {
+            x = x * x % n;
+            if (x == n - 1)
+                break;
+        }
+        if (i == s)
+            return false;
+    }
+    return true;
+}
+
+class RnsBasis
+{
+    vector<uint32_t> primes;
+    vector<uint32_t> cofactorInverses; // (M / p_i)^-1 mod p_i
+    vector<vector<BigInt>> tree;       // tree[0] holds the primes, tree.back()[0] is M
+    BigInt halfModulus;                // (M - 1) / 2
+
+public:
+    // Basis covering every |value| < 10^digits
+    explicit RnsBasis(size_t digits)
+    {
+        // Each prime above 2^30 adds 30 bits; one more bit for the sign
+        size_t bits = (size_t)ceil(digits * 3.3219280948873623) + 2;
+        for (uint32_t candidate = 0x7fffffff; primes.size() * 30 < bits; candidate -= 2)
+        {
+            if (isPrime32(candidate))
+                primes.push_back(candidate);
+        }
+
+        tree = productTreeLevels(vector<BigInt>(primes.begin(), primes.end()));
+        halfModulus = modulus() * 5;
+        halfModulus.shiftDigitsRight(1); // M is odd: floor(M / 2)
+
+        // M / p_i mod p_i as the product of the other primes, O(k^2) words once per basis
+        cofactorInverses.resize(primes.size());
+        parallelChunks(primes.size(), RNS_PARALLEL_GRAIN / primes.size() + 1, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++)
+            {
+                uint64_t cofactor = 1;
+                for (size_t j = 0; j < primes.size(); j++)
+                    if (j != i)
+                        cofactor = cofactor * (primes[j] % primes[i]) % primes[i];
+                cofactorInverses[i] = powMod32(cofactor, primes[i] - 2, primes[i]);
+            }
+        });
+    }
+
+    size_t size() const
+    {
+        return primes.size();
+    }
+
+    const vector<uint32_t> &moduli() const
+    {
+        return primes;
+    }
+
+    // Product of the basis primes
+    const BigInt &modulus() const
+    {
+        return tree.back()[0];
+    }
+
+    // x mod p_i for every prime. Large values go down a remainder tree over
+    // the basis' own product tree; smaller ones use Horner's rule over base
+    // 10^9 limbs, one pass of word arithmetic per prime. Large bases split
+    // the work across threads unless `parallel` is false.
+    vector<uint32_t> residues(const BigInt &x, bool parallel = true) const
+    {
+        bool negative = x.getIsNegative();
+        vector<uint32_t> result(primes.size());
+        vector<BigInt> nodes(1, x);
+        size_t depth = 0;
+        if (x.digitCount() >= RNS_TREE_MIN_DIGITS)
+        {
+            depth = min(RNS_TREE_LEAF_DEPTH, tree.size() - 1);
+            nodes = remainderTree(x, tree, false, parallel, depth);
+        }
+        // Node i of a tree level covers primes [i * 2^depth, (i + 1) * 2^depth)
+        vector<Limbs> limbs(nodes.size());
+        for (size_t i = 0; i < nodes.size(); i++)
+            limbs[i] = toLimbs(nodes[i].getNumber());
+        size_t grain = parallel ? RNS_PARALLEL_GRAIN / limbs[0].size() + 1 : primes.size();
+        parallelChunks(primes.size(), grain, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++)
+            {
+                const Limbs &digits = limbs.size() == 1 ? limbs[0] : limbs[i >> depth];
+                uint64_t p = primes[i], r = 0;
+                for (size_t j = digits.size(); j-- > 0;)
+                    r = (r * LIMB_BASE + digits[j]) % p;
+                result[i] = (uint32_t)(negative && r != 0 ? p - r : r);
+            }
+        });
+        return result;
+    }
+
+    // Batch conversion: one value per task, each converted sequentially
+    vector<vector<uint32_t>> residues(const vector<BigInt> &values) const
+    {
+        vector<vector<uint32_t>> result(values.size());
+        parallelChunks(values.size(), 1, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++)
+                result[i] = residues(values[i], false);
+        });
+        return result;
+    }
+
+    // Chinese remainder reconstruction into (-M/2, M/2). The sum of
+    // c_i * M/p_i is formed up the product tree of the primes
+    // (S = S_left * P_right + S_right * P_left), so every multiplication
+    // is balanced, and reduced modulo M with one Newton division.
+    BigInt value(const vector<uint32_t> &residueValues) const
+    {
+        if (residueValues.size() != primes.size())
+        {
+            throw invalid_argument("Residue count does not match the RNS basis");
+        }
+        vector<BigInt> level(primes.size());
+        for (size_t i = 0; i < primes.size(); i++)
+            level[i] = BigInt((int64_t)((uint64_t)residueValues[i] * cofactorInverses[i] % primes[i]));
+
+        for (size_t depth = 0; level.size() > 1; depth++)
+        {
+            const vector<BigInt> &products = tree[depth];
+            vector<BigInt> next((level.size() + 1) / 2);
+            parallelChunks(next.size(), treeGrain(depth), [&](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; i++)
+                {
+                    size_t l = 2 * i, r = 2 * i + 1;
+                    next[i] = r < level.size() ? level[l] * products[r] + level[r] * products[l] : level[l];
+                }
+            });
+            level = move(next);
+        }
+        BigInt x = divmodNewton(level[0], modulus()).second;
+        if (x > halfModulus)
+            x -= modulus();
+        return x;
+    }
+};
+
+class RnsInt
+{
+    shared_ptr<const RnsBasis> basis;
+    vector<uint32_t> residues;
+
+    // Applies op(a, b, p) to every residue pair
+    template <typename Op>
+    static RnsInt combine(const RnsInt &lhs, const RnsInt &rhs, Op op)
+    {
+        if (lhs.basis != rhs.basis)
+        {
+            throw invalid_argument("RnsInt operands use different bases");
+        }
+        const vector<uint32_t> &primes = lhs.basis->moduli();
+        vector<uint32_t> result(primes.size());
+        parallelChunks(primes.size(), RNS_PARALLEL_GRAIN, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++)
+                result[i] = op(lhs.residues[i], rhs.residues[i], primes[i]);
+        });
+        return RnsInt(lhs.basis, move(result));
+    }
+
+public:
+    RnsInt(shared_ptr<const RnsBasis> valueBasis, const BigInt &value)
+        : basis(move(valueBasis)), residues(basis->residues(value)) {}
+
+    RnsInt(shared_ptr<const RnsBasis> valueBasis, vector<uint32_t> residueValues)
+        : basis(move(valueBasis)), residues(move(residueValues))
+    {
+        if (residues.size() != basis->size())
+        {
+            throw invalid_argument("Residue count does not match the RNS basis");
+        }
+    }
+
+    const shared_ptr<const RnsBasis> &getBasis() const
+    {
+        return basis;
+    }
+
+    const vector<uint32_t> &residueValues() const
+    {
+        return residues;
+    }
+
+    // CRT reconstruction, exact while the value stayed within the basis range
+    BigInt toBigInt() const
+    {
+        TITAN_TRACE_SCOPE("RnsInt::toBigInt");
+        return basis->value(residues);
+    }
+
+    RnsInt operator-() const
+    {
+        RnsInt zero(basis, vector<uint32_t>(residues.size(), 0));
+        return zero - *this;
+    }
+
+    friend RnsInt operator+(const RnsInt &lhs, const RnsInt &rhs)
+    {
+        return combine(lhs, rhs, [](uint64_t a, uint64_t b, uint64_t p) { return (uint32_t)((a + b) % p); });
+    }
+
+    friend RnsInt operator-(const RnsInt &lhs, const RnsInt &rhs)
+    {
+        return combine(lhs, rhs, [](uint64_t a, uint64_t b, uint64_t p) { return (uint32_t)((a + p - b) % p); });
+    }
+
+    friend RnsInt operator*(const RnsInt &lhs, const RnsInt &rhs)
+    {
+        return combine(lhs, rhs, [](uint64_t a, uint64_t b, uint64_t p) { return (uint32_t)(a * b % p); });
+    }
+
+    RnsInt &operator+=(const RnsInt &other)
+    {
+        *this = *this + other;
+        return *this;
+    }
+
+    RnsInt &operator-=(const RnsInt &other)
+    {
+        *this = *this - other;
+        return *this;
+    }
+
+    RnsInt &operator*=(const RnsInt &other)
+    {
+        *this = *this * other;
+        return *this;
+    }
+};
+
+// Converts a whole batch of values to one basis, in parallel
+vector<RnsInt> toRns(const shared_ptr<const RnsBasis> &basis, const vector<BigInt> &values)
+{
+    TITAN_TRACE_SCOPE("toRns");
+    vector<vector<uint32_t>> residues = basis->residues(values);
+    vector<RnsInt> result;
+    result.reserve(values.size());
+    for (vector<uint32_t> &r : residues)
+        result.emplace_back(basis, move(r));
+    return result;
+}
+
+// ==================== ACCUMULATION ====================
+// An Accumulator sums many BigInts without building a BigInt per step. It
+// keeps base 10^9 lanes in 64-bit words, one set for positive and one for
+// negative terms, and adds each term's limbs straight from its digits
+// without propagating carries (carry-save). A lane gains less than 10^9
+// per term, so carries are settled only every ACCUMULATOR_CARRY_INTERVAL
+// terms, and once more when the total is read. Lanes grow geometrically
+// and can be reserved, so steady-state adds allocate nothing.
+// Accumulators merge lane by lane, which makes per-thread partial sums
+// cheap to combine.
+
+// Terms between carry passes: lanes stay below (interval + 1) * 10^9 < 2^64
+const uint64_t ACCUMULATOR_CARRY_INTERVAL = 1ULL << 33;
+
+class Accumulator
+{
+    struct Lanes
+    {
+        vector<uint64_t> limbs; // little-endian base 10^9, carries pending
+        uint64_t pending = 0;   // every limb is below (pending + 1) * 10^9
+
+        void settle()
+        {
+            uint64_t carry = 0;
+            for (uint64_t &limb : limbs)
+            {
+                limb += carry;
+                carry = limb / LIMB_BASE;
+                limb %= LIMB_BASE;
+            }
+            while (carry > 0)
+            {
+                limbs.push_back(carry % LIMB_BASE);
+                carry /= LIMB_BASE;
+            }
+            pending = 0;
+        }
+
+        void add(const string &digits)
+        {
+            size_t count = (digits.size() + LIMB_DIGITS - 1) / LIMB_DIGITS;
+            if (limbs.size() < count)
+                limbs.resize(count, 0);
+            const char *end = digits.data() + digits.size();
+            for (size_t i = 0; i < count; i++, end -= LIMB_DIGITS)
+            {
+                const char *begin = i + 1 < count ? end - LIMB_DIGITS : digits.data();
+                uint64_t limb = 0;
+                for (const char *c = begin; c < end; c++)
+                    limb = limb * 10 + (*c - '0');
+                limbs[i] += limb;
+            }
+            if (++pending >= ACCUMULATOR_CARRY_INTERVAL)
+                settle();
+        }
+
+        // Both sides are below ACCUMULATOR_CARRY_INTERVAL * 10^9 per limb,
+        // so the lane-wise sum still fits
+        void merge(const Lanes &other)
+        {
+            if (limbs.size() < other.limbs.size())
+                limbs.resize(other.limbs.size(), 0);
+            for (size_t i = 0; i < other.limbs.size(); i++)
+                limbs[i] += other.limbs[i];
+            pending += other.pending + 1;
+            if (pending >= ACCUMULATOR_CARRY_INTERVAL)
+                settle();
+        }
+
+        BigInt value() const
+        {
+            Lanes copy = *this;
+            copy.settle();
+            BigInt result;
+            result.setNumber(fromLimbs(Limbs(copy.limbs.begin(), copy.limbs.end())));
+            return result;
+        }
+    };
+
+    Lanes positive, negative;
+    size_t terms = 0;
+
+public:
+    Accumulator() {}
+
+    // Makes room for totals of up to `digits` digits
+    void reserve(size_t digits)
+    {
+        size_t limbs = digits / LIMB_DIGITS + 2;
+        positive.limbs.reserve(limbs);
+        negative.limbs.reserve(limbs);
+    }
+
+    // Total digits the lanes can hold before they reallocate
+    size_t capacity() const
+    {
+        return min(positive.limbs.capacity(), negative.limbs.capacity()) * LIMB_DIGITS;
+    }
+
+    // Number of terms added (merged accumulators count theirs)
+    size_t count() const
+    {
+        return terms;
+    }
+
+    Accumulator &add(const BigInt &value)
+    {
+        if (!value.isZero())
+            (value.isNegative ? negative : positive).add(value.number.str());
+        ++terms;
+        return *this;
+    }
+
+    Accumulator &operator+=(const BigInt &value)
+    {
+        return add(value);
+    }
+
+    // Adds other's running total into this one; other is unchanged
+    Accumulator &merge(const Accumulator &other)
+    {
+        positive.merge(other.positive);
+        negative.merge(other.negative);
+        terms += other.terms;
+        return *this;
+    }
+
+    // The sum so far as a BigInt; the accumulator can keep going
+    BigInt finalize() const
+    {
+        TITAN_TRACE_SCOPE("Accumulator::finalize");
+        return positive.value() - negative.value();
+    }
+
+    void clear()
+    {
+        positive.limbs.clear();
+        negative.limbs.clear();
+        positive.pending = negative.pending = 0;
+        terms = 0;
+    }
+};
+
+// ==================== COMPACT STORAGE ====================
+// CompactBigInt is an at-rest form for large in-memory collections: base
+// 10^9 limbs in one exact-size allocation (4 bytes per 9 digits instead
+// of one byte per digit) with the sign and limb count packed beside the
+// pointer, 16 bytes in all. It has no arithmetic; convert back with
+// toBigInt() to compute. Values of up to one limb need no allocation.
+
+class CompactBigInt
+{
+    unique_ptr<uint32_t[]> limbs; // little-endian, no leading zero limbs
+    uint32_t count = 0;           // limbs held; 0 means the value is 0
+    uint32_t small = 0;           // the only limb when count == 1
+    // The sign lives in the top bit of count
+    static const uint32_t SIGN_BIT = 0x80000000u;
+
+    uint32_t size() const
+    {
+        return count & ~SIGN_BIT;
+    }
+
+    const uint32_t *data() const
+    {
+        return size() == 1 ? &small : limbs.get();
+    }
+
+public:
+    CompactBigInt() {}
+
+    explicit CompactBigInt(const BigInt &value)
+    {
+        Limbs digits = toLimbs(value.getNumber());
+        trimLimbs(digits);
+        size_t n = value.isZero() ? 0 : digits.size();
+        if (n >= SIGN_BIT)
+        {
+            throw length_error("Value too large for CompactBigInt");
+        }
+        if (n == 1)
+            small = digits[0];
+        else if (n > 1)
+        {
+            limbs.reset(new uint32_t[n]);
+            copy(digits.begin(), digits.end(), limbs.get());
+        }
+        count = (uint32_t)n | (value.getIsNegative() && n ? SIGN_BIT : 0);
+    }
+
+    CompactBigInt(const CompactBigInt &other) : count(other.count), small(other.small)
+    {
+        if (size() > 1)
+        {
+            limbs.reset(new uint32_t[size()]);
+            copy(other.limbs.get(), other.limbs.get() + size(), limbs.get());
+        }
+    }
+
+    // Leaves other as zero, a valid value
+    CompactBigInt(CompactBigInt &&other) noexcept : limbs(move(other.limbs)), count(other.count), small(other.small)
+    {
+        other.count = other.small = 0;
+    }
+
+    CompactBigInt &operator=(CompactBigInt other)
+    {
+        limbs.swap(other.limbs);
+        count = other.count;
+        small = other.small;
+        return *this;
+    }
+
+    BigInt toBigInt() const
+    {
+        BigInt result;
+        if (size() > 0)
+        {
+            result.setNumber(fromLimbs(Limbs(data(), data() + size())));
+            result.setIsNegative((count & SIGN_BIT) != 0);
+        }
+        return result;
+    }
+
+    // Bytes this value keeps alive: the object plus its limb array
+    size_t memoryUsage() const
+    {
+        return sizeof(CompactBigInt) + (size() > 1 ? size() * sizeof(uint32_t) : 0);
+    }
+
+    friend bool operator==(const CompactBigInt &lhs, const CompactBigInt &rhs)
+    {
+        return lhs.count == rhs.count && equal(lhs.data(), lhs.data() + lhs.size(), rhs.data());
+    }
+
+    friend bool operator!=(const CompactBigInt &lhs, const CompactBigInt &rhs)
+    {
+        return !(lhs == rhs);
+    }
+};
+
+// ==================== CONTAINER ALGORITHMS ====================
+// Sorting and reductions over vectors of BigInt, split across threads.
+// Sorting compares 64-bit prefix keys (BigInt::sortKey) and touches the
+// digits only on ties; sums fill one Accumulator per thread and merge
+// them pairwise. For products see product(), which already multiplies
+// along a parallel product tree.
+
+// Values per thread before a sort or reduction is split across threads
+const size_t PARALLEL_SORT_GRAIN = 16384;
+const size_t PARALLEL_REDUCE_GRAIN = 4096;
+
+// Sorts values ascending. Each value is reduced to its sortKey once, so
+// nearly every comparison is one integer comparison; only equal keys
+// (same sign, length and first 11 digits) fall back to compare(). Chunks
+// are sorted on separate threads and then merged pairwise.
+void parallelSort(vector<BigInt> &values)
+{
+    TITAN_TRACE_SCOPE("parallelSort");
+    struct Entry
+    {
+        uint64_t key;
+        const BigInt *value;
+    };
+    size_t n = values.size();
+    vector<Entry> entries(n);
+    parallelChunks(n, PARALLEL_SORT_GRAIN, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++)
+            entries[i] = {values[i].sortKey(), &values[i]};
+    });
+    auto less = [](const Entry &a, const Entry &b) {
+        return a.key != b.key ? a.key < b.key : a.value->compare(*b.value) < 0;
+    };
+
+    size_t chunks = min<size_t>(max(1u, thread::hardware_concurrency()), n / PARALLEL_SORT_GRAIN);
+    chunks = max<size_t>(chunks, 1);
+    vector<size_t> bounds(chunks + 1);
+    for (size_t c = 0; c <= chunks; c++)
+        bounds[c] = n * c / chunks;
+    parallelChunks(chunks, 1, [&](size_t lo, size_t hi) {
+        for (size_t c = lo; c < hi; c++)
+            sort(entries.begin() + bounds[c], entries.begin() + bounds[c + 1], less);
+    });
+    for (size_t width = 1; width < chunks; width *= 2)
+    {
+        size_t merges = (chunks + 2 * width - 1) / (2 * width);
+        parallelChunks(merges, 1, [&](size_t lo, size_t hi) {
+            for (size_t m = lo; m < hi; m++)
+            {
+                size_t first = 2 * width * m, middle = min(first + width, chunks), last = min(first + 2 * width, chunks);
+                inplace_merge(entries.begin() + bounds[first], entries.begin() + bounds[middle],
+                              entries.begin() + bounds[last], less);
+            }
+        });
+    }
+
+    vector<BigInt> sorted;
+    sorted.reserve(n);
+    for (const Entry &entry : entries)
+        sorted.push_back(*entry.value); // shares the digit buffer
+    values.swap(sorted);
+}
+
+// Sum of all values. Each thread adds its chunk into its own Accumulator
+// and the accumulators are merged pairwise.
+BigInt parallelSum(const vector<BigInt> &values)
+{
+    TITAN_TRACE_SCOPE("parallelSum");
+    size_t n = values.size();
+    size_t chunks = max<size_t>(1, min<size_t>(max(1u, thread::hardware_concurrency()), n / PARALLEL_REDUCE_GRAIN));
+    vector<Accumulator> partial(chunks);
+    parallelChunks(chunks, 1, [&](size_t lo, size_t hi) {
+        for (size_t c = lo; c < hi; c++)
+            for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; i++)
+                partial[c] += values[i];
+    });
+    for (size_t width = 1; width < chunks; width *= 2)
+    {
+        for (size_t c = 0; c + width < chunks; c += 2 * width)
+            partial[c].merge(partial[c + width]);
+    }
+    return partial[0].finalize();
+}
+
+// Smallest and largest value, each thread scanning its own chunk with
+// compare(); throws for an empty vector
+pair<BigInt, BigInt> parallelMinMax(const vector<BigInt> &values)
+{
+    TITAN_TRACE_SCOPE("parallelMinMax");
+    if (values.empty())
+    {
+        throw invalid_argument("parallelMinMax of an empty vector");
+    }
+    size_t n = values.size();
+    size_t chunks = max<size_t>(1, min<size_t>(max(1u, thread::hardware_concurrency()), n / PARALLEL_REDUCE_GRAIN));
+    vector<size_t> lowest(chunks), highest(chunks);
+    parallelChunks(chunks, 1, [&](size_t lo, size_t hi) {
+        for (size_t c = lo; c < hi; c++)
+        {
+            size_t first = n * c / chunks, last = n * (c + 1) / chunks;
+            lowest[c] = highest[c] = first;
+            for (size_t i = first + 1; i < last; i++)
+            {
+                if (values[i].compare(values[lowest[c]]) < 0)
+                    lowest[c] = i;
+                else if (values[i].compare(values[highest[c]]) > 0)
+                    highest[c] = i;
+            }
+        }
+    });
+    size_t low = lowest[0], high = highest[0];
+    for (size_t c = 1; c < chunks; c++)
+    {
+        if (values[lowest[c]].compare(values[low]) < 0)
+            low = lowest[c];
+        if (values[highest[c]].compare(values[high]) > 0)
+            high = highest[c];
+    }
+    return {values[low], values[high]};
+}
+
+// ==================== TUNING ====================
+// Crossover thresholds differ between machines, so the ones that decide a
+// kernel are variables rather than constants. They keep their compiled-in
+// defaults unless a thresholds file, "name value" per line ('#' starts a
+// comment), is loaded: the menu, --batch and --serve binaries load the one
+// named by --thresholds or else $TITANINT_THRESHOLDS, before starting any
+// work. Build with -DTITANINT_TUNER for a binary that measures the kernels
+// on this machine and writes the file.
+
+struct TunableThreshold
+{
+    const char *name;
+    size_t *value;
+    size_t minimum; // values below this are rejected when loading
+};
+
+static const TunableThreshold tunableThresholds[] = {
+    {"karatsuba_threshold", &KARATSUBA_THRESHOLD, 2},
+    {"product_tree_leaf", &PRODUCT_TREE_LEAF, 1},
+    {"rns_tree_min_digits", &RNS_TREE_MIN_DIGITS, 1},
+};
+
+// Applies the file only if all of it is valid. Throws runtime_error naming
+// the file and line for an unknown name, a malformed line or a value below
+// its minimum, and when the file cannot be read; no threshold changes then.
+// Not thread-safe: call before any BigInt work starts.
+void loadThresholds(const string &path)
+{
+    ifstream in(path);
+    if (!in)
+    {
+        throw runtime_error("Cannot open thresholds file " + path);
+    }
+    const size_t count = sizeof(tunableThresholds) / sizeof(tunableThresholds[0]);
+    size_t values[count];
+    for (size_t i = 0; i < count; i++)
+        values[i] = *tunableThresholds[i].value;
+
+    string line;
+    for (size_t lineNumber = 1; getline(in, line); lineNumber++)
+    {
+        istringstream fields(line.substr(0, line.find('#')));
+        string name, value, extra;
+        if (!(fields >> name))
+            continue;
+        string where = path + ":" + to_string(lineNumber) + ": ";
+        size_t i = 0;
+        while (i < count && name != tunableThresholds[i].name)
+            i++;
+        if (i == count)
+        {
+            throw runtime_error(where + "unknown threshold " + name);
+        }
+        if (!(fields >> value) || fields >> extra || value.size() > 18 || value.find_first_not_of("0123456789") != string::npos)
+        {
+            throw runtime_error(where + "expected \"" + name + " <count>\"");
+        }
+        values[i] = stoull(value);
+        if (values[i] < tunableThresholds[i].minimum)
+        {
+            throw runtime_error(where + name + " must be at least " + to_string(tunableThresholds[i].minimum));
+        }
+    }
+    if (in.bad())
+    {
+        throw runtime_error("Cannot read thresholds file " + path);
+    }
+    for (size_t i = 0; i < count; i++)
+        *tunableThresholds[i].value = values[i];
+}
+
+// Writes the current thresholds in the format loadThresholds reads
+void saveThresholds(ostream &os)
+{
+    os << "# TitanInt crossover thresholds (see -DTITANINT_TUNER)" << endl;
+    for (const TunableThreshold &threshold : tunableThresholds)
+        os << threshold.name << " " << *threshold.value << endl;
+}
+
+#ifdef TITANINT_TUNER
+
+// Seconds per call of body: repeated until 20 ms have passed, best of three
+template <typename Body>
+static double secondsPerCall(Body body)
+{
+    double best = numeric_limits<double>::max();
+    for (int trial = 0; trial < 3; trial++)
+    {
+        size_t calls = 0;
+        auto start = chrono::steady_clock::now();
+        chrono::duration<double> elapsed(0);
+        do
+        {
+            body();
+            ++calls;
+            elapsed = chrono::steady_clock::now() - start;
+        } while (elapsed.count() < 0.02);
+        best = min(best, elapsed.count() / calls);
+    }
+    return best;
+}
+
+static BigInt tunerOperand(size_t digits, uint64_t seed)
+{
+    string text(digits, '0');
+    for (size_t i = 0; i < digits; i++)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        text[i] = char('0' + (seed >> 33) % 10);
+    }
+    text[0] = '7';
+    return BigInt(text);
+}
+
+// Sets *threshold to the candidate with the lowest total cost over all
+// workloads. Each workload's time is taken relative to its best
+// candidate, so large sizes do not outweigh small ones.
+template <typename Workload>
+static void tuneThreshold(const char *name, size_t *threshold, const vector<size_t> &candidates, const vector<Workload> &workloads)
+{
+    vector<vector<double>> times(candidates.size(), vector<double>(workloads.size()));
+    for (size_t c = 0; c < candidates.size(); c++)
+    {
+        *threshold = candidates[c];
+        for (size_t w = 0; w < workloads.size(); w++)
+            times[c][w] = secondsPerCall(workloads[w]);
+    }
+    size_t best = 0;
+    double bestCost = numeric_limits<double>::max();
+    for (size_t c = 0; c < candidates.size(); c++)
+    {
+        double cost = 0;
+        for (size_t w = 0; w < workloads.size(); w++)
+        {
+            double fastest = numeric_limits<double>::max();
+            for (size_t other = 0; other < candidates.size(); other++)
+                fastest = min(fastest, times[other][w]);
+            cost += times[c][w] / fastest;
+        }
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            best = c;
+        }
+    }
+    *threshold = candidates[best];
+    cout << name << ": " << *threshold << " (" << bestCost / workloads.size() << "x the per-size best on average)" << endl;
+}
+
+// Measures the kernels and sets every tunable threshold for this machine
+void tuneThresholds()
+{
+    using Workload = function<void()>;
+
+    // Multiplication, squaring and Newton division all run through
+    // mulLimbs, so one threshold serves them; operands span one to five
+    // Karatsuba levels
+    vector<Workload> multiply;
+    for (size_t limbs : {48, 96, 192, 384, 768, 1536})
+    {
+        BigInt a = tunerOperand(limbs * LIMB_DIGITS, limbs), b = tunerOperand(limbs * LIMB_DIGITS, limbs + 1);
+        BigInt wide = a * b + a;
+        multiply.push_back([a, b] { BigInt product = a * b; });
+        multiply.push_back([a] { BigInt square = a * a; });
+        multiply.push_back([wide, b] { BigInt quotient = wide / b; });
+    }
+    tuneThreshold("karatsuba_threshold", &KARATSUBA_THRESHOLD, {8, 12, 16, 24, 32, 48, 64, 96}, multiply);
+
+    vector<Workload> products;
+    for (size_t count : {256, 2048})
+    {
+        vector<BigInt> factors;
+        for (size_t i = 0; i < count; i++)
+            factors.push_back(tunerOperand(1 + i % 12, i));
+        products.push_back([factors] { BigInt result = product(factors); });
+    }
+    tuneThreshold("product_tree_leaf", &PRODUCT_TREE_LEAF, {4, 8, 16, 32, 64}, products);
+
+    // Radix conversion into residues: the smallest size at which the
+    // remainder tree beats the word loop becomes the switch-over point
+    size_t treeFrom = 0;
+    for (size_t digits : {5000, 10000, 20000, 40000, 80000})
+    {
+        RnsBasis basis(digits);
+        BigInt x = tunerOperand(digits, digits);
+        RNS_TREE_MIN_DIGITS = digits + 1;
+        double horner = secondsPerCall([&] { basis.residues(x); });
+        RNS_TREE_MIN_DIGITS = digits;
+        double tree = secondsPerCall([&] { basis.residues(x); });
+        if (tree < horner)
+        {
+            treeFrom = digits;
+            break;
+        }
+    }
+    RNS_TREE_MIN_DIGITS = treeFrom ? treeFrom : 160000;
+    cout << "rns_tree_min_digits: " << RNS_TREE_MIN_DIGITS << endl;
+}
+
+#endif
+
+// ==================== WORKER POOL ====================
+// A fixed set of threads that live as long as the pool, for modes that
+// keep handing out work (batch blocks, server requests) and should not
+// start threads for every piece of it. submit() queues a task and returns;
+// run() spreads indices over the workers and the calling thread and waits.
+// Tasks must not throw, and a task must not call run() on its own pool.
+
+class WorkerPool
+{
+    vector<thread> threads;
+    mutex lock;
+    condition_variable wake;
+    deque<function<void()>> tasks;
+    bool stopping = false;
+
+    void work()
+    {
+        for (;;)
+        {
+            function<void()> task;
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [&] { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return;
+                task = move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    // Starts `count` threads; with none, run() uses the caller alone
+    explicit WorkerPool(size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            threads.emplace_back([this] { work(); });
+    }
+
+    // Finishes the queued tasks, then joins every thread
+    ~WorkerPool()
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread &worker : threads)
+            worker.join();
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    size_t size() const
+    {
+        return threads.size();
+    }
+
+    void submit(function<void()> task)
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            tasks.push_back(move(task));
+        }
+        wake.notify_one();
+    }
+
+    // Runs body(i) once for every i in [0, count) and returns when all are done
+    template <typename Body>
+    void run(size_t count, Body body)
+    {
+        atomic<size_t> next(0);
+        auto drain = [&] {
+            for (size_t i; (i = next.fetch_add(1, memory_order_relaxed)) < count;)
+                body(i);
+        };
+        size_t helpers = min(threads.size(), count > 0 ? count - 1 : 0), finished = 0;
+        mutex doneLock;
+        condition_variable done;
+        for (size_t h = 0; h < helpers; h++)
+        {
+            submit([&] {
+                drain();
+                // Notified under the lock: the waiter may return and
+                // destroy `done` as soon as it sees the count
+                lock_guard<mutex> guard(doneLock);
+                if (++finished == helpers)
+                    done.notify_one();
+            });
+        }
+        drain();
+        unique_lock<mutex> guard(doneLock);
+        done.wait(guard, [&] { return finished == helpers; });
+    }
+};
+
+// ==================== BATCH MODE ====================
+// `TitanInt --batch [file]` evaluates one operation per line from the file
+// (or stdin) and writes one result line per input line, in input order:
+//
+//   <a> <op> <b>   op is + - * / % ^ gcd cmp (cmp prints -1, 0 or 1)
+//   <op> <a>       op is sqrt abs neg
+//
+// Blank lines and '#' comments give blank output lines; a bad line gives
+// "error: <reason>" and the run continues. Lines are read in blocks and
+// each block is evaluated on one worker pool kept for the whole run,
+// every worker reusing its own token and operand objects.
+
+// Lines per block: large enough to keep every worker busy, small enough
+// that results start streaming out early
+const size_t BATCH_BLOCK_LINES = 65536;
+// Lines per worker before a block is split across threads
+const size_t BATCH_PARALLEL_GRAIN = 1024;
+
+struct BatchWorkspace
+{
+    string tokens[4];
+    BigInt lhs, rhs; // parsed in place with assign()
+};
+
+// Evaluates one batch line into out (without the newline)
+static void evaluateBatchLine(const string &line, BatchWorkspace &work, string &out)
+{
+    size_t count = 0, pos = 0;
+    while (count < 4)
+    {
+        pos = line.find_first_not_of(" \t\r", pos);
+        if (pos == string::npos || line[pos] == '#')
+            break;
+        size_t end = line.find_first_of(" \t\r", pos);
+        work.tokens[count++].assign(line, pos, end == string::npos ? string::npos : end - pos);
+        pos = end;
+    }
+    if (count == 0)
+    {
+        out.clear();
+        return;
+    }
+
+    try
+    {
+        const string &op = count == 2 ? work.tokens[0] : work.tokens[1];
+        if (count == 2)
+        {
+            work.lhs.assign(work.tokens[1]);
+            if (op == "sqrt")
+                out = isqrt(work.lhs).toString();
+            else if (op == "abs")
+                out = work.lhs.getNumber();
+            else if (op == "neg")
+                out = (-work.lhs).toString();
+            else
+                throw invalid_argument("unknown unary operation " + op);
+            return;
+        }
+        if (count != 3)
+        {
+            throw invalid_argument("expected <a> <op> <b> or <op> <a>");
+        }
+        work.lhs.assign(work.tokens[0]);
+        work.rhs.assign(work.tokens[2]);
+        if (op == "+")
+            out = (work.lhs + work.rhs).toString();
+        else if (op == "-")
+            out = (work.lhs - work.rhs).toString();
+        else if (op == "*")
+            out = (work.lhs * work.rhs).toString();
+        else if (op == "/")
+            out = (work.lhs / work.rhs).toString();
+        else if (op == "%")
+            out = (work.lhs % work.rhs).toString();
+        else if (op == "^")
+        {
+            uint64_t exponent;
+            if (work.rhs.getIsNegative() || !work.rhs.magnitudeToUint64(exponent))
+                throw invalid_argument("exponent must be a non-negative 64-bit integer");
+            out = pow(work.lhs, exponent).toString();
+        }
+        else if (op == "gcd")
+            out = gcd(work.lhs, work.rhs).toString();
+        else if (op == "cmp")
+            out = to_string(work.lhs.compare(work.rhs));
+        else
+            throw invalid_argument("unknown operation " + op);
+    }
+    catch (const exception &e)
+    {
+        out = "error: ";
+        out += e.what();
+    }
+}
+
+// Runs a whole stream; returns the number of lines that produced an error
+size_t runBatch(istream &in, ostream &out)
+{
+    TITAN_TRACE_SCOPE("runBatch");
+    unsigned workers = max(1u, thread::hardware_concurrency());
+    vector<BatchWorkspace> workspaces(workers);
+    WorkerPool pool(workers - 1); // the caller is the last worker
+    vector<string> lines(BATCH_BLOCK_LINES), results(BATCH_BLOCK_LINES);
+    string buffer;
+    size_t errors = 0;
+    while (in)
+    {
+        size_t count = 0;
+        while (count < lines.size() && getline(in, lines[count]))
+            ++count;
+        if (count == 0)
+            break;
+
+        // One contiguous range per workspace, so no two threads share one
+        size_t chunk = max<size_t>(BATCH_PARALLEL_GRAIN, (count + workers - 1) / workers);
+        pool.run((count + chunk - 1) / chunk, [&](size_t t) {
+            for (size_t i = t * chunk; i < min(count, (t + 1) * chunk); i++)
+                evaluateBatchLine(lines[i], workspaces[t], results[i]);
+        });
+
+        buffer.clear();
+        for (size_t i = 0; i < count; i++)
+        {
+            errors += results[i].compare(0, 7, "error: ") == 0;
+            buffer += results[i];
+            buffer += '\n';
+        }
+        out.write(buffer.data(), buffer.size());
+    }
+    out.flush();
+    return errors;
+}
+
+// ==================== RPC SERVER ====================
+// `TitanInt --serve <socket path | port>` keeps the engine running behind
+// a Unix domain socket (any address containing '/') or 127.0.0.1:<port>.
+// One epoll loop serves every connection; clients may pipeline any number
+// of requests and get the responses back in request order.
+//
+// Integers are little-endian. Request frame:
+//   u32 length of the rest, u32 request id, u8 op, operands
+// Operand: u8 0, u32 n, n bytes of signed decimal text (inline value)
+//       or u8 1, u32 cache id (a value stored by RPC_CACHE_PUT)
+// Response frame:
+//   u32 length of the rest, u32 request id, u8 status (0 ok, 1 error),
+//   the result as decimal text or the error message
+//
+// RPC_CACHE_PUT stores its operand server-wide and answers with the cache
+// id; putting an equal value again returns the same id and adds a
+// reference, and RPC_CACHE_DROP (operand: the id as inline text) removes
+// one. Cached moduli are then sent as five bytes instead of their digits.
+// The epoll thread only does I/O, parsing and cache changes. Each
+// connection hands up to RPC_BATCH_LIMIT parsed requests at a time to a
+// worker pool, which signals the loop through an eventfd when they are
+// done, so a slow request never holds up the other clients. Operands and
+// results are bounded (RPC_MAX_DIGITS and friends) so that no single
+// request can run for minutes or exhaust memory.
+#ifdef __linux__
+
+enum RpcOp : uint8_t
+{
+    RPC_ADD = 1,
+    RPC_SUB,
+    RPC_MUL,
+    RPC_DIV,
+    RPC_MOD,
+    RPC_POW,
+    RPC_GCD,
+    RPC_CMP,
+    RPC_SQRT,
+    RPC_CACHE_PUT = 32,
+    RPC_CACHE_DROP
+};
+
+// Frames longer than this close the connection
+const size_t RPC_MAX_FRAME = 64 << 20;
+// Distinct values the operand cache holds before puts are refused
+const size_t RPC_CACHE_LIMIT = 1 << 16;
+// Requests per worker task
+const size_t RPC_PARALLEL_GRAIN = 256;
+// Requests one connection has with the workers at a time
+const size_t RPC_BATCH_LIMIT = 4096;
+// Longest operand and longest result of * and ^, in digits
+const size_t RPC_MAX_DIGITS = 1000000;
+// Longest operand of sqrt and gcd, whose costs grow faster
+const size_t RPC_MAX_ROOT_DIGITS = 200000;
+const size_t RPC_MAX_GCD_DIGITS = 200000;
+
+struct RpcRequest
+{
+    uint32_t id;
+    uint8_t op;
+    BigInt operands[2];
+    bool done;      // answered while parsing (cache ops, malformed frames)
+    bool failed;
+    string payload; // result text or error message
+};
+
+struct RpcConnection
+{
+    int fd;
+    string input, output;
+    size_t written = 0;            // bytes of output already sent
+    vector<RpcRequest> requests;   // reused across batches
+    size_t batch = 0;              // requests[0, batch) belong to the current batch
+    bool busy = false;             // the batch is with the workers
+    atomic<size_t> remaining{0};   // worker tasks of the batch still running
+    bool peerOpen = true;          // the peer may still send
+    bool broken = false;           // close as soon as the workers are done
+    uint32_t watched = 0;          // events registered with epoll (0: none)
+};
+
+struct RpcCacheEntry
+{
+    BigInt value;
+    size_t references;
+};
+
+class RpcServer
+{
+    int listener = -1, poller = -1, wakeup = -1;
+    string unixPath;
+    unordered_map<int, RpcConnection> connections;
+    unordered_map<uint32_t, RpcCacheEntry> cache;
+    unordered_map<BigInt, uint32_t> cacheIds;
+    uint32_t nextCacheId = 1;
+    unique_ptr<WorkerPool> workers;
+    mutex finishedLock;
+    vector<int> finished; // connections whose batch the workers completed
+
+    static uint32_t readU32(const string &buffer, size_t pos)
     {
-        return isNegative;
+        return (uint32_t)(uint8_t)buffer[pos] | (uint32_t)(uint8_t)buffer[pos + 1] << 8 |
+               (uint32_t)(uint8_t)buffer[pos + 2] << 16 | (uint32_t)(uint8_t)buffer[pos + 3] << 24;
     }
-    void setNumber(const string &num)
+
+    static void appendU32(string &buffer, uint32_t value)
     {
-        number = num;
+        for (int shift = 0; shift < 32; shift += 8)
+            buffer.push_back(char(value >> shift));
     }
-    void setIsNegative(bool neg)
+
+    static size_t operandCount(uint8_t op)
     {
-        isNegative = neg;
+        return op == RPC_SQRT || op == RPC_CACHE_PUT || op == RPC_CACHE_DROP ? 1 : 2;
     }
-};
 
-// Binary addition operator (x + y)
+    // Decodes one operand at pos (advancing it) and resolves cache ids
+    BigInt readOperand(const string &frame, size_t &pos, size_t end)
+    {
+        if (pos + 5 > end)
+            throw invalid_argument("truncated operand");
+        uint8_t kind = (uint8_t)frame[pos];
+        uint32_t word = readU32(frame, pos + 1);
+        pos += 5;
+        if (kind == 1)
+        {
+            auto entry = cache.find(word);
+            if (entry == cache.end())
+                throw invalid_argument("unknown cache id " + to_string(word));
+            return entry->second.value;
+        }
+        if (kind != 0 || word > end - pos)
+            throw invalid_argument("malformed operand");
+        if (word > RPC_MAX_DIGITS + 1)
+            throw invalid_argument("operand longer than " + to_string(RPC_MAX_DIGITS) + " digits");
+        pos += word;
+        return BigInt(frame.substr(pos - word, word));
+    }
 
-BigInt operator+(BigInt lhs, const BigInt &rhs)
-{
-    if (lhs.getIsNegative() == rhs.getIsNegative())
+    string cachePut(const BigInt &value)
     {
-        string a = lhs.getNumber(), b = rhs.getNumber();
-        if (a.size() < b.size())
-            swap(a, b);
-        int carry = 0;
-        int n = a.size(), m = b.size();
-        string result = "";
-        for (int i = 0; i < n; i++)
+        auto known = cacheIds.find(value);
+        if (known != cacheIds.end())
         {
-            int da = a[n - 1 - i] - '0';
-            int db = (i < m) ? (b[m - 1 - i] - '0') : 0;
-            int sum = da + db + carry;
-            carry = sum / 10;
-            result.push_back((sum % 10) + '0');
+            cache[known->second].references++;
+            return to_string(known->second);
         }
-        if (carry)
-            result.push_back(carry + '0');
-        reverse(result.begin(), result.end());
-        BigInt res;
-        res.setNumber(result);
-        res.setIsNegative(lhs.getIsNegative());
-        return res;
+        if (cache.size() >= RPC_CACHE_LIMIT)
+            throw runtime_error("operand cache is full");
+        uint32_t id = nextCacheId++;
+        cache[id] = {value, 1};
+        cacheIds[value] = id;
+        return to_string(id);
     }
-    else
+
+    void cacheDrop(const BigInt &idValue)
     {
-        return lhs - (-rhs);
+        uint64_t id;
+        auto entry = idValue.magnitudeToUint64(id) ? cache.find((uint32_t)id) : cache.end();
+        if (entry == cache.end())
+            throw invalid_argument("unknown cache id " + idValue.toString());
+        if (--entry->second.references == 0)
+        {
+            cacheIds.erase(entry->second.value);
+            cache.erase(entry);
+        }
     }
-}
 
-// Binary subtraction operator (x - y)
+    static void checkDigits(size_t digits, size_t limit, const char *what)
+    {
+        if (digits > limit)
+            throw invalid_argument(string(what) + " longer than " + to_string(limit) + " digits");
+    }
 
-BigInt operator-(BigInt lhs, const BigInt &rhs)
-{
-    if (lhs.getIsNegative() != rhs.getIsNegative())
+    static string evaluate(const RpcRequest &request)
     {
-        return lhs + (-rhs);
+        const BigInt &a = request.operands[0], &b = request.operands[1];
+        switch (request.op)
+        {
+        case RPC_ADD:
+            return (a + b).toString();
+        case RPC_SUB:
+            return (a - b).toString();
+        case RPC_MUL:
+            checkDigits(a.digitCount() + b.digitCount(), RPC_MAX_DIGITS, "product");
+            return (a * b).toString();
+        case RPC_DIV:
+            return (a / b).toString();
+        case RPC_MOD:
+            return (a % b).toString();
+        case RPC_POW:
+        {
+            uint64_t exponent;
+            if (b.getIsNegative() || !b.magnitudeToUint64(exponent))
+                throw invalid_argument("exponent must be a non-negative 64-bit integer");
+            // 0, 1 and -1 stay one digit; anything else grows by at most
+            // digitCount(a) digits per factor
+            uint64_t base;
+            if ((!a.magnitudeToUint64(base) || base > 1) && exponent > RPC_MAX_DIGITS / a.digitCount())
+                throw invalid_argument("power longer than " + to_string(RPC_MAX_DIGITS) + " digits");
+            return pow(a, exponent).toString();
+        }
+        case RPC_GCD:
+            checkDigits(max(a.digitCount(), b.digitCount()), RPC_MAX_GCD_DIGITS, "gcd operand");
+            return gcd(a, b).toString();
+        case RPC_CMP:
+            return to_string(a.compare(b));
+        case RPC_SQRT:
+            checkDigits(a.digitCount(), RPC_MAX_ROOT_DIGITS, "sqrt operand");
+            return isqrt(a).toString();
+        }
+        throw invalid_argument("unknown operation " + to_string(request.op));
     }
-    int cmp = lhs.compareMagnitude(rhs);
-    if (cmp == 0)
-        return BigInt(0);
 
-    bool resultNegative = false;
-    string a = lhs.getNumber(), b = rhs.getNumber();
-    if (cmp < 0)
+    // Parses up to RPC_BATCH_LIMIT complete frames from the input buffer
+    // and hands them to the workers (or answers them at once when none
+    // needs evaluating); false if the connection must be closed
+    bool dispatch(RpcConnection &connection)
     {
-        swap(a, b);
-        resultNegative = true;
+        string &input = connection.input;
+        size_t pos = 0, count = 0, evaluated = 0;
+        while (count < RPC_BATCH_LIMIT && input.size() - pos >= 4)
+        {
+            size_t length = readU32(input, pos);
+            if (length < 5 || length > RPC_MAX_FRAME)
+                return false;
+            if (input.size() - pos - 4 < length)
+                break;
+            size_t end = pos + 4 + length;
+            if (count == connection.requests.size())
+                connection.requests.emplace_back();
+            RpcRequest &request = connection.requests[count++];
+            request.id = readU32(input, pos + 4);
+            request.op = (uint8_t)input[pos + 8];
+            request.done = request.failed = false;
+            // Operands and cache changes are resolved here, in request
+            // order, so a put is visible to the requests behind it
+            try
+            {
+                size_t at = pos + 9;
+                for (size_t i = 0; i < operandCount(request.op); i++)
+                    request.operands[i] = readOperand(input, at, end);
+                if (request.op == RPC_CACHE_PUT)
+                {
+                    request.payload = cachePut(request.operands[0]);
+                    request.done = true;
+                }
+                else if (request.op == RPC_CACHE_DROP)
+                {
+                    cacheDrop(request.operands[0]);
+                    request.payload.clear();
+                    request.done = true;
+                }
+            }
+            catch (const exception &e)
+            {
+                request.payload = e.what();
+                request.done = request.failed = true;
+            }
+            evaluated += !request.done;
+            pos = end;
+        }
+        input.erase(0, pos);
+        connection.batch = count;
+        if (evaluated == 0)
+        {
+            respond(connection);
+            return true;
+        }
+
+        connection.busy = true;
+        size_t tasks = (count + RPC_PARALLEL_GRAIN - 1) / RPC_PARALLEL_GRAIN;
+        connection.remaining = tasks;
+        for (size_t t = 0; t < tasks; t++)
+        {
+            workers->submit([this, &connection, t, count] {
+                for (size_t i = t * RPC_PARALLEL_GRAIN; i < min(count, (t + 1) * RPC_PARALLEL_GRAIN); i++)
+                {
+                    RpcRequest &request = connection.requests[i];
+                    if (request.done)
+                        continue;
+                    try
+                    {
+                        request.payload = evaluate(request);
+                    }
+                    catch (const exception &e)
+                    {
+                        request.payload = e.what();
+                        request.failed = true;
+                    }
+                }
+                if (connection.remaining.fetch_sub(1, memory_order_acq_rel) == 1)
+                {
+                    {
+                        lock_guard<mutex> guard(finishedLock);
+                        finished.push_back(connection.fd);
+                    }
+                    uint64_t one = 1;
+                    ssize_t ignored = write(wakeup, &one, sizeof(one));
+                    (void)ignored;
+                }
+            });
+        }
+        return true;
     }
-    int n = a.size(), m = b.size();
-    string result = "";
-    int borrow = 0;
-    for (int i = 0; i < n; i++)
+
+    // Queues the responses of the current batch, in request order
+    void respond(RpcConnection &connection)
     {
-        int da = a[n - 1 - i] - '0' - borrow;
-        int db = (i < m) ? (b[m - 1 - i] - '0') : 0;
-        if (da < db)
+        for (size_t i = 0; i < connection.batch; i++)
         {
-            da += 10;
-            borrow = 1;
+            RpcRequest &request = connection.requests[i];
+            appendU32(connection.output, (uint32_t)(request.payload.size() + 5));
+            appendU32(connection.output, request.id);
+            connection.output.push_back(char(request.failed ? 1 : 0));
+            connection.output += request.payload;
+            request.operands[0] = request.operands[1] = BigInt(); // release digit buffers
+        }
+        connection.batch = 0;
+    }
+
+    // True while the connection can take another batch: none is with the
+    // workers and the peer is reading its responses
+    static bool accepting(const RpcConnection &connection)
+    {
+        return !connection.busy && !connection.broken && connection.output.size() < RPC_MAX_FRAME;
+    }
+
+    // Hands out the connection's complete frames, batch by batch, until
+    // one goes to the workers; their wakeup continues with the rest
+    void serve(RpcConnection &connection)
+    {
+        while (accepting(connection) && connection.input.size() >= 4)
+        {
+            size_t buffered = connection.input.size();
+            if (!dispatch(connection))
+                connection.broken = true;
+            else if (connection.input.size() == buffered)
+                break; // only part of a frame so far
+        }
+    }
+
+    // Sends what the socket accepts; false once the peer cannot take more
+    bool flush(RpcConnection &connection)
+    {
+        while (connection.written < connection.output.size())
+        {
+            ssize_t sent = send(connection.fd, connection.output.data() + connection.written,
+                                connection.output.size() - connection.written, MSG_NOSIGNAL);
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    return false;
+                break;
+            }
+            connection.written += sent;
+        }
+        if (connection.written == connection.output.size())
+        {
+            connection.output.clear();
+            connection.written = 0;
+        }
+        return true;
+    }
+
+    // Serves and sends what it can, then closes the connection if it is
+    // done or registers the events it is waiting for. A connection with a
+    // batch out stays open, and one that cannot take a batch reads ahead
+    // by at most a frame.
+    void settle(RpcConnection &connection)
+    {
+        // Sending first may free room for the next batch
+        if (!connection.broken && !flush(connection))
+            connection.broken = true;
+        serve(connection);
+        if (!connection.broken && !flush(connection))
+            connection.broken = true;
+        bool done = connection.broken || (!connection.peerOpen && connection.output.empty());
+        if (done && !connection.busy)
+        {
+            close(connection.fd);
+            return;
+        }
+
+        uint32_t events = 0;
+        if (!connection.broken)
+        {
+            if (connection.peerOpen && (accepting(connection) || connection.input.size() < RPC_MAX_FRAME))
+                events |= EPOLLIN;
+            if (!connection.output.empty())
+                events |= EPOLLOUT;
+        }
+        // A hung-up peer is reported even with no events asked for, so a
+        // connection with nothing to wait for leaves epoll until its batch
+        // is back
+        if (events == connection.watched)
+            return;
+        epoll_event event = {};
+        event.events = events;
+        event.data.fd = connection.fd;
+        int op = events == 0 ? EPOLL_CTL_DEL : connection.watched == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        epoll_ctl(poller, op, connection.fd, &event);
+        connection.watched = events;
+    }
+
+    // Takes back the batches the workers have completed
+    void collect()
+    {
+        uint64_t signals;
+        ssize_t ignored = read(wakeup, &signals, sizeof(signals));
+        (void)ignored;
+        vector<int> ready;
+        {
+            lock_guard<mutex> guard(finishedLock);
+            ready.swap(finished);
+        }
+        for (int fd : ready)
+        {
+            RpcConnection &connection = connections[fd];
+            connection.busy = false;
+            respond(connection);
+            settle(connection);
+        }
+    }
+
+    void close(int fd)
+    {
+        if (connections[fd].watched != 0)
+            epoll_ctl(poller, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections.erase(fd);
+    }
+
+    void accept()
+    {
+        for (;;)
+        {
+            int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                return;
+            connections[fd].fd = fd;
+            settle(connections[fd]);
+        }
+    }
+
+    // Reads until the socket would block; false once the peer is gone
+    bool receive(RpcConnection &connection)
+    {
+        char chunk[65536];
+        for (;;)
+        {
+            ssize_t got = recv(connection.fd, chunk, sizeof(chunk), 0);
+            if (got > 0)
+            {
+                connection.input.append(chunk, got);
+                continue;
+            }
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return true;
+            return false;
+        }
+    }
+
+public:
+    // Binds and listens; throws runtime_error on failure
+    explicit RpcServer(const string &address)
+    {
+        if (address.find('/') != string::npos)
+        {
+            sockaddr_un local = {};
+            if (address.size() >= sizeof(local.sun_path))
+                throw runtime_error("Socket path too long: " + address);
+            local.sun_family = AF_UNIX;
+            memcpy(local.sun_path, address.c_str(), address.size() + 1);
+            listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            unlink(address.c_str());
+            if (listener < 0 || bind(listener, (sockaddr *)&local, sizeof(local)) < 0)
+                throw runtime_error("Cannot bind " + address + ": " + strerror(errno));
+            unixPath = address;
         }
         else
         {
-            borrow = 0;
+            sockaddr_in loopback = {};
+            loopback.sin_family = AF_INET;
+            loopback.sin_port = htons((uint16_t)stoul(address));
+            loopback.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            int reuse = 1;
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if (listener < 0 || bind(listener, (sockaddr *)&loopback, sizeof(loopback)) < 0)
+                throw runtime_error("Cannot bind 127.0.0.1:" + address + ": " + strerror(errno));
         }
-        result.push_back((da - db) + '0');
+        if (listen(listener, SOMAXCONN) < 0)
+            throw runtime_error(string("Cannot listen: ") + strerror(errno));
+        poller = epoll_create1(EPOLL_CLOEXEC);
+        wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (poller < 0 || wakeup < 0)
+            throw runtime_error(string("Cannot create the event loop: ") + strerror(errno));
+        for (int fd : {listener, wakeup})
+        {
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            epoll_ctl(poller, EPOLL_CTL_ADD, fd, &event);
+        }
+        // A few more threads than a small machine has cores, so short
+        // requests still get through while long ones run
+        workers.reset(new WorkerPool(max(4u, thread::hardware_concurrency())));
     }
-    while (result.size() > 1 && result.back() == '0')
-        result.pop_back();
-    reverse(result.begin(), result.end());
 
-    BigInt res;
-    res.setNumber(result);
-    res.setIsNegative(lhs.getIsNegative() ? !resultNegative : resultNegative);
-    if (res.getNumber() == "0")
-        res.setIsNegative(false);
-    return res;
+    ~RpcServer()
+    {
+        workers.reset(); // finishes outstanding batches while their connections exist
+        if (wakeup >= 0)
+            ::close(wakeup);
+        for (auto &connection : connections)
+            ::close(connection.first);
+        if (poller >= 0)
+            ::close(poller);
+        if (listener >= 0)
+            ::close(listener);
+        if (!unixPath.empty())
+            unlink(unixPath.c_str());
+    }
+
+    // Serves until stop becomes true (checked at least every 100 ms)
+    void run(const volatile sig_atomic_t &stop)
+    {
+        epoll_event events[256];
+        while (!stop)
+        {
+            int ready = epoll_wait(poller, events, 256, 100);
+            for (int i = 0; i < ready; i++)
+            {
+                int fd = events[i].data.fd;
+                if (fd == listener)
+                {
+                    accept();
+                    continue;
+                }
+                if (fd == wakeup)
+                {
+                    collect();
+                    continue;
+                }
+                auto found = connections.find(fd);
+                if (found == connections.end())
+                    continue; // closed earlier in this round
+                RpcConnection &connection = found->second;
+                if (connection.peerOpen && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+                    connection.peerOpen = receive(connection);
+                // A closed peer still gets the responses to what it sent
+                settle(connection);
+            }
+        }
+    }
+};
+
+static volatile sig_atomic_t rpcStopRequested = 0;
+
+// Runs the server until SIGINT or SIGTERM; returns the exit status
+int runServer(const string &address)
+{
+    try
+    {
+        RpcServer server(address);
+        signal(SIGINT, [](int) { rpcStopRequested = 1; });
+        signal(SIGTERM, [](int) { rpcStopRequested = 1; });
+        cerr << "Serving on " << address << endl;
+        server.run(rpcStopRequested);
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
 }
 
-// Binary multiplication operator (x * y)
+#endif
+
+// ==================== PROPERTY TESTS AND FUZZING ====================
+// Self-checking builds of the arithmetic engine. Every operator result is
+// compared against a slow digit-by-digit reference and checked against
+// algebraic identities; a failure prints the operands.
+//
+//   -DTITANINT_PROPERTY_TESTS  main runs randomized property tests over
+//                              every tier boundary and rounding edge
+//                              (./TitanInt [seed] [rounds])
+//                              and exits non-zero on any failure
+//   -DTITANINT_FUZZ            no main; defines LLVMFuzzerTestOneInput, which
+//                              aborts on a failure:
+//   clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address -DTITANINT_FUZZ TitanInt.cpp
+#if defined(TITANINT_PROPERTY_TESTS) || defined(TITANINT_FUZZ)
+
+// Reference arithmetic on magnitude strings: schoolbook digit loops with
+// nothing shared with the tiers under test
+
+static int refCompare(const string &a, const string &b)
+{
+    if (a.size() != b.size())
+        return a.size() < b.size() ? -1 : 1;
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
 
-BigInt operator*(BigInt lhs, const BigInt &rhs)
+static string refStrip(string digits)
 {
-    string a = lhs.getNumber(), b = rhs.getNumber();
-    int n = a.size(), m = b.size();
-    vector<int> result(n + m, 0);
-    for (int i = n - 1; i >= 0; i--)
+    size_t first = digits.find_first_not_of('0');
+    return first == string::npos ? "0" : digits.substr(first);
+}
+
+static string refAdd(const string &a, const string &b)
+{
+    string result;
+    int carry = 0;
+    for (size_t i = 0; i < max(a.size(), b.size()) || carry; i++)
     {
-        for (int j = m - 1; j >= 0; j--)
+        int sum = carry;
+        if (i < a.size())
+            sum += a[a.size() - 1 - i] - '0';
+        if (i < b.size())
+            sum += b[b.size() - 1 - i] - '0';
+        result.push_back(char('0' + sum % 10));
+        carry = sum / 10;
+    }
+    reverse(result.begin(), result.end());
+    return refStrip(result);
+}
+
+// a - b for a >= b
+static string refSub(const string &a, const string &b)
+{
+    string result;
+    int borrow = 0;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        int diff = (a[a.size() - 1 - i] - '0') - borrow - (i < b.size() ? b[b.size() - 1 - i] - '0' : 0);
+        borrow = diff < 0;
+        result.push_back(char('0' + diff + 10 * borrow));
+    }
+    reverse(result.begin(), result.end());
+    return refStrip(result);
+}
+
+static string refMul(const string &a, const string &b)
+{
+    vector<int> sums(a.size() + b.size(), 0);
+    for (size_t i = a.size(); i-- > 0;)
+    {
+        int carry = 0;
+        for (size_t j = b.size(); j-- > 0;)
         {
-            int mul = (a[i] - '0') * (b[j] - '0');
-            int sum = mul + result[i + j + 1];
-            result[i + j + 1] = sum % 10;
-            result[i + j] += sum / 10;
+            int cell = sums[i + j + 1] + (a[i] - '0') * (b[j] - '0') + carry;
+            sums[i + j + 1] = cell % 10;
+            carry = cell / 10;
         }
+        sums[i] += carry;
     }
-    string resStr;
-    bool leading = true;
-    for (int num : result)
+    string result;
+    for (int digit : sums)
+        result.push_back(char('0' + digit));
+    return refStrip(result);
+}
+
+// Floor quotient and remainder of magnitudes by repeated subtraction, b != 0
+static pair<string, string> refDivmod(const string &a, const string &b)
+{
+    string quotient, remainder = "0";
+    for (char digit : a)
     {
-        if (leading && num == 0)
-            continue;
-        leading = false;
-        resStr.push_back(num + '0');
+        remainder = refStrip(remainder + digit);
+        char count = '0';
+        while (refCompare(remainder, b) >= 0)
+        {
+            remainder = refSub(remainder, b);
+            ++count;
+        }
+        quotient.push_back(count);
     }
-    if (resStr.empty())
-        resStr = "0";
-    BigInt res;
-    res.setNumber(resStr);
-    res.setIsNegative(lhs.getIsNegative() != rhs.getIsNegative() && resStr != "0");
-    return res;
+    return {refStrip(quotient), remainder};
 }
 
-// Binary division operator (x / y)
-BigInt operator/(BigInt lhs, const BigInt &rhs)
+// Signed reference results in operator<< form, with the library's
+// conventions: quotients truncate, remainders take the dividend's sign
+static string refSigned(bool negative, const string &magnitude)
+{
+    return negative && magnitude != "0" ? "-" + magnitude : magnitude;
+}
+
+static string refSum(const BigInt &a, const BigInt &b, bool subtract)
+{
+    const string &x = a.getNumber(), &y = b.getNumber();
+    bool xNeg = a.getIsNegative(), yNeg = b.getIsNegative() != subtract;
+    if (xNeg == yNeg)
+        return refSigned(xNeg, refAdd(x, y));
+    return refCompare(x, y) >= 0 ? refSigned(xNeg, refSub(x, y)) : refSigned(yNeg, refSub(y, x));
+}
+
+// Reports a failed property with its operands; returns ok
+static bool propertyHolds(bool ok, const char *property, const BigInt &a, const BigInt &b)
 {
-    if (rhs.getNumber() == "0")
+    if (!ok)
     {
-        throw runtime_error("Division by zero");
+        cerr << "Property failed: " << property << "\n  a = " << a << "\n  b = " << b << endl;
     }
+    return ok;
+}
 
-    if (lhs.compareMagnitude(rhs) < 0)
+// Checks every operator on (a, b), plus identities involving c; returns
+// the number of failed properties
+static size_t checkArithmetic(const BigInt &a, const BigInt &b, const BigInt &c)
+{
+    size_t failures = 0;
+    auto check = [&](bool ok, const char *property) {
+        failures += !propertyHolds(ok, property, a, b);
+    };
+
+    BigInt sum = a + b, difference = a - b, prod = a * b;
+    check(sum.toString() == refSum(a, b, false), "a + b matches the reference");
+    check(difference.toString() == refSum(a, b, true), "a - b matches the reference");
+    check(prod.toString() == refSigned(a.getIsNegative() != b.getIsNegative(), refMul(a.getNumber(), b.getNumber())),
+          "a * b matches the reference");
+    check(sum == b + a && prod == b * a, "+ and * commute");
+    check((a * a).toString() == refMul(a.getNumber(), a.getNumber()), "a * a matches the reference");
+    check(a * (b + c) == prod + a * c, "a * (b + c) == a * b + a * c");
+    check((a + b) + c == a + (b + c), "+ associates");
+    check(difference + b == a, "(a - b) + b == a");
+
+    int order = refCompare(a.getNumber(), b.getNumber());
+    if (a.getIsNegative() != b.getIsNegative())
+        order = a.isZero() && b.isZero() ? 0 : (a.getIsNegative() ? -1 : 1);
+    else if (a.getIsNegative())
+        order = -order;
+    check(a.compare(b) == order && b.compare(a) == -order, "compare matches the reference");
+    check((a < b) == (order < 0) && (a == b) == (order == 0) && (a >= b) == (order >= 0), "relational operators agree");
+    check(a.sortKey() == b.sortKey() || (a.sortKey() < b.sortKey()) == (order < 0), "sortKey order is consistent");
+    check(BigInt(a.toString()) == a, "string round trip");
+
+    BigInt inPlace = a;
+    inPlace += b;
+    check(inPlace == sum, "+= matches +");
+    inPlace = a;
+    inPlace -= b;
+    check(inPlace == difference, "-= matches -");
+    inPlace = a;
+    inPlace *= b;
+    check(inPlace == prod, "*= matches *");
+
+    if (!b.isZero())
     {
-        return BigInt(0);
+        pair<string, string> qr = refDivmod(a.getNumber(), b.getNumber());
+        BigInt q = a / b, r = a % b;
+        check(q.toString() == refSigned(a.getIsNegative() != b.getIsNegative(), qr.first), "a / b matches the reference");
+        check(r.toString() == refSigned(a.getIsNegative(), qr.second), "a % b matches the reference");
+        check(q * b + r == a, "(a / b) * b + a % b == a");
+        check(divmod(a, Divisor(b, 1 + a.digitCount() / 3)) == make_pair(q, r), "Divisor matches / and %");
+        inPlace = a;
+        inPlace /= b;
+        check(inPlace == q, "/= matches /");
+        inPlace = a;
+        inPlace %= b;
+        check(inPlace == r, "%= matches %");
     }
 
-    BigInt dividend = lhs;
-    BigInt divisor = rhs;
-    dividend.setIsNegative(false);
-    divisor.setIsNegative(false);
+    // Native right operands take the scalar paths, including the
+    // fallback above UINT64_MAX / 10
+    uint64_t bMagnitude;
+    if (b.magnitudeToUint64(bMagnitude) && bMagnitude <= (uint64_t)INT64_MAX)
+    {
+        int64_t small = b.getIsNegative() ? -(int64_t)bMagnitude : (int64_t)bMagnitude;
+        check(a + small == sum && a - small == difference && a * small == prod, "native +, -, * match BigInt operands");
+        if (small != 0)
+            check(a / small == a / b && a % small == a % b, "native /, % match BigInt operands");
+    }
 
-    string quotientStr;
-    BigInt current(0);
+    BigInt magnitude = a.getIsNegative() ? -a : a;
+    BigInt root = isqrt(magnitude);
+    check(root * root <= magnitude && (root + 1) * (root + 1) > magnitude, "isqrt brackets |a|");
+    BigInt divisor = gcd(a, b);
+    check(divisor.isZero() ? a.isZero() && b.isZero() : (a % divisor).isZero() && (b % divisor).isZero(),
+          "gcd divides both operands");
+    return failures;
+}
 
-    for (size_t i = 0; i < dividend.getNumber().size(); i++)
-    {
+#endif
 
-        current = current * BigInt(10);
-        int digit = dividend.getNumber()[i] - '0';
-        current = current + BigInt(digit);
+#ifdef TITANINT_PROPERTY_TESTS
 
-        int count = 0;
-        while (current.compareMagnitude(divisor) >= 0)
-        {
-            current = current - divisor;
-            count++;
-        }
-        quotientStr += to_string(count);
+// Digit counts on both sides of every tier switch: one limb (9), the
+// native scalar limit (19 digits), the long double base case of the
+// Newton reciprocal (15 digits), and one and two levels of Karatsuba
+// (KARATSUBA_THRESHOLD limbs and twice that). The RNS remainder tree
+// (RNS_TREE_MIN_DIGITS), Divisor reciprocal growth and the rounding
+// edges of BigDecimal and BigFloat have generators of their own below.
+static vector<size_t> tierBoundaryDigits()
+{
+    vector<size_t> sizes;
+    size_t karatsuba = KARATSUBA_THRESHOLD * LIMB_DIGITS;
+    for (size_t centre : {size_t(1), size_t(LIMB_DIGITS), size_t(15), size_t(19), karatsuba, 2 * karatsuba, 4 * karatsuba})
+    {
+        for (size_t d = centre > 2 ? centre - 2 : 1; d <= centre + 2; d++)
+            sizes.push_back(d);
     }
+    return sizes;
+}
 
-    BigInt result(quotientStr);
-    result.removeLeadingZeros();
-    if (result.getNumber() == "0")
+// Random value with `digits` digits and a random sign. A quarter of the
+// values take shapes that stress carries and Newton corrections:
+// 99...9, 10...0 and 10...01.
+static BigInt randomOperand(mt19937_64 &rng, size_t digits)
+{
+    string text;
+    switch (rng() % 8)
     {
-        result.setIsNegative(false);
+    case 0:
+        text.assign(digits, '9');
+        break;
+    case 1:
+        text = "1" + string(digits - 1, '0');
+        break;
+    case 2:
+        text = digits == 1 ? "1" : "1" + string(digits - 2, '0') + "1";
+        break;
+    default:
+        text.push_back(char('1' + rng() % 9));
+        for (size_t i = 1; i < digits; i++)
+            text.push_back(char('0' + rng() % 10));
     }
-    else
+    if (rng() % 2)
+        text = "-" + text;
+    return BigInt(text);
+}
+
+// Operand whose last `dropped` digits sit on a rounding edge: exactly
+// half (5, 50...0), just above or below it (50...01, 49...9), zero, or
+// random, behind `kept` random leading digits (none for a value below
+// one unit of the kept part)
+static BigInt roundingOperand(mt19937_64 &rng, size_t kept, size_t dropped)
+{
+    string text;
+    for (size_t i = 0; i < kept; i++)
+        text.push_back(char((i == 0 ? '1' : '0') + rng() % (i == 0 ? 9 : 10)));
+    if (dropped > 0)
     {
-        result.setIsNegative(lhs.getIsNegative() != rhs.getIsNegative());
+        string tail(dropped, '0');
+        switch (rng() % 6)
+        {
+        case 0:
+            tail[0] = '5';
+            break;
+        case 1:
+            tail[0] = '5';
+            tail.back() = tail.size() > 1 ? '1' : '6';
+            break;
+        case 2:
+            tail.assign(dropped, '9');
+            tail[0] = '4';
+            break;
+        case 3:
+            break;
+        default:
+            for (char &digit : tail)
+                digit = char('0' + rng() % 10);
+        }
+        text += tail;
     }
-
-    return result;
+    if (text.empty())
+        text = "0";
+    if (rng() % 2)
+        text = "-" + text;
+    return BigInt(text);
 }
 
-// Binary modulus operator (x % y)
-BigInt operator%(BigInt lhs, const BigInt &rhs)
+// Whether a reference rounding moves away from zero. half compares the
+// discarded part with one half unit (-1, 0, 1); odd is the parity of the
+// last kept digit.
+static bool refRoundsAway(RoundingMode mode, bool negative, int half, bool inexact, bool odd)
 {
-    if (rhs.getNumber() == "0")
-    {
-        throw runtime_error("modulus by zero");
-    }
-    if (lhs.compareMagnitude(rhs) < 0)
-    {
-        return lhs;
-    }
-    BigInt result = lhs - (lhs / rhs) * rhs;
-    if (result.getNumber() == "0")
-    {
-        result.setIsNegative(false);
-    }
-    else
+    if (!inexact)
+        return false;
+    switch (mode)
     {
-        result.setIsNegative(lhs.getIsNegative());
+    case ROUND_HALF_EVEN:
+        return half > 0 || (half == 0 && odd);
+    case ROUND_HALF_UP:
+        return half >= 0;
+    case ROUND_HALF_DOWN:
+        return half > 0;
+    case ROUND_UP:
+        return true;
+    case ROUND_DOWN:
+        return false;
+    case ROUND_CEILING:
+        return !negative;
+    case ROUND_FLOOR:
+        return negative;
     }
-    return result;
+    return false;
 }
 
-// Equality comparison operator (x == y)
-bool operator==(const BigInt &lhs, const BigInt &rhs)
+// magnitude with its last `drop` digits rounded off; sticky marks a
+// non-zero remainder lying below the last digit of magnitude
+static string refDropDigits(const string &magnitude, size_t drop, RoundingMode mode, bool negative, bool sticky = false)
 {
-    return ((lhs.getIsNegative() == rhs.getIsNegative()) && (lhs.getNumber() == rhs.getNumber()));
+    if (drop == 0 && !sticky)
+        return magnitude;
+    string padded = magnitude.size() < drop ? string(drop - magnitude.size(), '0') + magnitude : magnitude;
+    string kept = refStrip(padded.substr(0, padded.size() - drop)), dropped = padded.substr(padded.size() - drop);
+    int half = -1;
+    if (!dropped.empty() && dropped[0] >= '5')
+        half = dropped[0] > '5' || sticky || dropped.find_first_not_of('0', 1) != string::npos ? 1 : 0;
+    bool inexact = sticky || dropped.find_first_not_of('0') != string::npos;
+    bool away = refRoundsAway(mode, negative, half, inexact, (kept.back() - '0') % 2);
+    return away ? refAdd(kept, "1") : kept;
 }
-// Inequality comparison operator (x != y)
-bool operator!=(const BigInt &lhs, const BigInt &rhs)
+
+// The reference value of sign and magnitude at p significant digits,
+// half-even, as a BigFloat built without rounding
+static BigFloat refFloat(bool negative, const string &magnitude, int64_t exponent, size_t p, bool sticky = false)
 {
-    return !(lhs == rhs);
+    size_t drop = magnitude.size() > p ? magnitude.size() - p : 0;
+    string kept = refDropDigits(magnitude, drop, ROUND_HALF_EVEN, negative, sticky);
+    return BigFloat(BigInt(refSigned(negative, kept)), exponent + (int64_t)drop, p + 1);
 }
 
-// Less-than comparison operator (x < y)
-bool operator<(const BigInt &lhs, const BigInt &rhs)
+// A Divisor reused for dividends on both sides of each point where its
+// reciprocal has to grow (twice the divisor's length, then twice that),
+// and for a short dividend after growing
+static size_t checkDivisorGrowth(mt19937_64 &rng)
 {
-    if (lhs.getIsNegative() && !rhs.getIsNegative())
+    size_t failures = 0;
+    BigInt d = randomOperand(rng, 20 + rng() % 40);
+    size_t digits = d.digitCount();
+    Divisor prepared(d);
+    for (size_t centre : {2 * digits, 4 * digits + 1, digits + 1})
     {
-        return true;
-    }
-    if (!lhs.getIsNegative() && rhs.getIsNegative())
-    {
-        return false;
+        for (size_t n = centre - 1; n <= centre + 2; n++)
+        {
+            BigInt a = randomOperand(rng, n);
+            pair<string, string> qr = refDivmod(a.getNumber(), d.getNumber());
+            pair<BigInt, BigInt> result = prepared.divmod(a);
+            failures += !propertyHolds(result.first.toString() == refSigned(a.getIsNegative() != d.getIsNegative(), qr.first) &&
+                                           result.second.toString() == refSigned(a.getIsNegative(), qr.second),
+                                       "a growing Divisor matches the reference", a, d);
+        }
     }
+    return failures;
+}
 
-    int magnitudeComparison = lhs.compareMagnitude(rhs);
-
-    if (!lhs.getIsNegative())
+// Residues of x on one side of the remainder tree crossover, against a
+// digit-by-digit reference for a few primes, and the CRT round trip
+static size_t checkRnsCrossover(const RnsBasis &basis, const BigInt &x, mt19937_64 &rng)
+{
+    vector<uint32_t> residues = basis.residues(x);
+    bool matches = true;
+    for (size_t i : {size_t(0), basis.size() - 1, size_t(rng() % basis.size())})
     {
-
-        return magnitudeComparison < 0;
+        uint64_t p = basis.moduli()[i], r = 0;
+        for (char digit : x.getNumber())
+            r = (r * 10 + (digit - '0')) % p;
+        matches = matches && residues[i] == (x.getIsNegative() && r != 0 ? p - r : r);
     }
-    else
+    size_t failures = !propertyHolds(matches, "residues match the reference", x, BigInt((int64_t)RNS_TREE_MIN_DIGITS));
+    failures += !propertyHolds(basis.value(residues) == x, "RNS round trip", x, BigInt((int64_t)RNS_TREE_MIN_DIGITS));
+    return failures;
+}
+
+// BigDecimal rescaling and division in every rounding mode, with the
+// cut at, just inside and just past the first digit
+static size_t checkDecimalRounding(mt19937_64 &rng)
+{
+    size_t failures = 0;
+    size_t drop = 1 + rng() % 25;
+    BigInt u = roundingOperand(rng, rng() % 3 == 0 ? rng() % 2 : 1 + rng() % 25, drop);
+    BigInt v = randomOperand(rng, 1 + rng() % 20);
+    int64_t scale = (int64_t)(rng() % 40) - 10, resultScale = (int64_t)(rng() % 30) - 5;
+    for (int m = ROUND_HALF_EVEN; m <= ROUND_FLOOR; m++)
     {
-        return magnitudeComparison > 0;
+        RoundingMode mode = (RoundingMode)m;
+        BigDecimal rescaled = BigDecimal(u, scale).setScale(scale - (int64_t)drop, mode);
+        string expected = refSigned(u.getIsNegative(), refDropDigits(u.getNumber(), drop, mode, u.getIsNegative()));
+        failures += !propertyHolds(rescaled.unscaledValue().toString() == expected && rescaled.getScale() == scale - (int64_t)drop,
+                                   "setScale rounds like the reference", u, BigInt((int64_t)m));
+
+        // (u / 10^scale) / (v / 10^vScale) at resultScale, vScale = 0:
+        // u * 10^(resultScale - scale) / v, one quotient digit past the cut
+        int64_t shift = resultScale - scale + 1;
+        string numerator = u.getNumber(), denominator = v.getNumber();
+        if (shift >= 0)
+            numerator += string(shift, '0');
+        else
+            denominator += string(-shift, '0');
+        pair<string, string> qr = refDivmod(refStrip(numerator), denominator);
+        bool negative = u.getIsNegative() != v.getIsNegative() && !(qr.first == "0" && qr.second == "0");
+        expected = refSigned(negative, refDropDigits(qr.first, 1, mode, negative, qr.second != "0"));
+        BigDecimal quotient = BigDecimal(u, scale).divide(BigDecimal(v), resultScale, mode);
+        failures += !propertyHolds(quotient.unscaledValue().toString() == expected, "divide rounds like the reference", u, v);
     }
-
-    return false;
+    return failures;
 }
 
-// Less-than-or-equal comparison operator (x <= y)
-bool operator<=(const BigInt &lhs, const BigInt &rhs)
+// Correctly rounded BigFloat results at precision p: rounding on
+// construction, products, sums with operands reaching below the last
+// digit, and quotients
+static size_t checkFloatRounding(mt19937_64 &rng)
 {
-    return (lhs < rhs) || (lhs == rhs);
+    size_t failures = 0;
+    size_t p = 1 + rng() % 40;
+    auto check = [&](const BigFloat &result, const BigFloat &expected, const char *property, const BigInt &a, const BigInt &b) {
+        failures += !propertyHolds(result == expected && result.getPrecision() == p, property, a, b);
+    };
+
+    BigInt m = roundingOperand(rng, p - rng() % 2, 1 + rng() % 3);
+    int64_t e = (int64_t)(rng() % 60) - 30;
+    check(BigFloat(m, e, p), refFloat(m.getIsNegative(), m.getNumber(), e, p), "BigFloat rounds like the reference", m, BigInt(e));
+
+    BigInt a = randomOperand(rng, 1 + rng() % p), b = randomOperand(rng, 1 + rng() % p);
+    BigFloat x(a, 0, p), y(b, 0, p);
+    check(x * y, refFloat(a.getIsNegative() != b.getIsNegative(), refMul(a.getNumber(), b.getNumber()), 0, p),
+          "BigFloat * rounds like the reference", a, b);
+
+    size_t shift = rng() % (p + 4);
+    BigInt scaled = a;
+    scaled.shiftDigitsLeft(shift);
+    string sum = refSum(scaled, b, false);
+    bool negative = sum[0] == '-';
+    check(x + BigFloat(b, -(int64_t)shift, p), refFloat(negative, negative ? sum.substr(1) : sum, -(int64_t)shift, p),
+          "BigFloat + rounds like the reference", a, b);
+
+    if (!b.isZero())
+    {
+        // Enough extra digits that the quotient has more than p of them
+        size_t extra = p + 1 + b.digitCount();
+        pair<string, string> qr = refDivmod(a.getNumber() + string(extra, '0'), b.getNumber());
+        check(x / y, refFloat(a.getIsNegative() != b.getIsNegative(), qr.first, -(int64_t)extra, p, qr.second != "0"),
+              "BigFloat / rounds like the reference", a, b);
+    }
+    return failures;
 }
 
-// Greater-than comparison operator (x > y)
-bool operator>(const BigInt &lhs, const BigInt &rhs)
+// Runs `rounds` rounds from `seed`; returns the number of failed properties
+size_t runPropertyTests(uint64_t seed, size_t rounds)
 {
-    return !(lhs <= rhs);
+    mt19937_64 rng(seed);
+    vector<size_t> sizes = tierBoundaryDigits();
+    size_t failures = 0, checks = 0;
+    RnsBasis basis(RNS_TREE_MIN_DIGITS + 2);
+
+    for (size_t round = 0; round < rounds; round++)
+    {
+        // Every pair of boundary sizes once per round, then random sizes
+        // up to a few Karatsuba levels with unbalanced operands
+        for (size_t i = 0; i < sizes.size(); i++)
+        {
+            size_t other = sizes[rng() % sizes.size()];
+            failures += checkArithmetic(randomOperand(rng, sizes[i]), randomOperand(rng, other), randomOperand(rng, 1 + rng() % 40));
+            failures += checkArithmetic(randomOperand(rng, sizes[i] + other), randomOperand(rng, other), BigInt(0));
+            checks += 2;
+        }
+        for (int i = 0; i < 20; i++)
+        {
+            size_t lhs = 1 + rng() % 1200, rhs = 1 + rng() % 1200;
+            failures += checkArithmetic(randomOperand(rng, lhs), randomOperand(rng, rhs), randomOperand(rng, 1 + rng() % 300));
+            checks++;
+        }
+        failures += checkArithmetic(BigInt(0), randomOperand(rng, 1 + rng() % 50), BigInt(0));
+        failures += checkArithmetic(randomOperand(rng, 1 + rng() % 50), BigInt(0), BigInt(0));
+        checks += 2;
+
+        // Product trees around the sequential leaf size and the reductions
+        size_t count = PRODUCT_TREE_LEAF - 2 + rng() % 5 + (round % 4 == 3 ? PRODUCT_PARALLEL_MIN : 0);
+        vector<BigInt> factors;
+        BigInt expectedProduct(1), expectedSum(0);
+        for (size_t i = 0; i < count; i++)
+        {
+            factors.push_back(randomOperand(rng, 1 + rng() % 12));
+            expectedProduct = expectedProduct * factors.back();
+            expectedSum = expectedSum + factors.back();
+        }
+        failures += !propertyHolds(product(factors) == expectedProduct, "product matches a sequential fold", factors[0], BigInt((int64_t)count));
+        failures += !propertyHolds(parallelSum(factors) == expectedSum, "parallelSum matches a sequential fold", factors[0], BigInt((int64_t)count));
+        vector<BigInt> sorted = factors;
+        parallelSort(sorted);
+        failures += !propertyHolds(is_sorted(sorted.begin(), sorted.end()), "parallelSort orders values", factors[0], BigInt((int64_t)count));
+        checks += 3;
+
+        // One value per round on the Horner or the remainder tree side of
+        // the RNS crossover, cycling through both neighbours and the limit
+        size_t rnsDigits = RNS_TREE_MIN_DIGITS - 1 + round % 3;
+        failures += checkRnsCrossover(basis, randomOperand(rng, rnsDigits), rng);
+        checks += 2;
+
+        failures += checkDivisorGrowth(rng);
+        checks += 12;
+        for (int i = 0; i < 10; i++)
+        {
+            failures += checkDecimalRounding(rng) + checkFloatRounding(rng);
+            checks += 2 * (ROUND_FLOOR + 1) + 4;
+        }
+    }
+
+    cout << checks << " property checks from seed " << seed << ": " << failures << " failures" << endl;
+    return failures;
 }
 
-// Greater-than-or-equal comparison operator (x >= y)
-bool operator>=(const BigInt &lhs, const BigInt &rhs)
+#endif
+
+#ifdef TITANINT_FUZZ
+
+// Operand bytes become digits (byte % 10) and the first byte picks the
+// split point and the signs, so any input is a valid case; the raw input
+// is also fed to the string constructor
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
 {
-    return (lhs > rhs) || (lhs == rhs);
+    try
+    {
+        BigInt parsed(string((const char *)data, size));
+        if (!propertyHolds(BigInt(parsed.toString()) == parsed, "string round trip", parsed, parsed))
+            abort();
+    }
+    catch (const invalid_argument &)
+    {
+    }
+    if (size < 2)
+        return 0;
+
+    size_t split = 1 + data[0] % (size - 1);
+    auto operand = [&](size_t lo, size_t hi, bool negative) {
+        string digits = "0";
+        for (size_t i = lo; i < hi; i++)
+            digits.push_back(char('0' + data[i] % 10));
+        return BigInt((negative ? "-" : "") + digits);
+    };
+    BigInt a = operand(1, split, data[0] & 0x40), b = operand(split, size, data[0] & 0x80);
+    if (checkArithmetic(a, b, a - b) != 0)
+        abort();
+    return 0;
 }
 
+#endif
+
 // ==================== TEST FUNCTIONS ====================
 
 void runBasicTests()
@@ -641,6 +6329,34 @@ void runComparisonTests()
     cout << "a <= c: " << (a <= c) << " (expected: 1)" << endl;
     cout << "a >= c: " << (a >= c) << " (expected: 1)" << endl;
     cout << "zero == 0: " << (zero == BigInt(0)) << " (expected: 1)" << endl;
+    cout << "a.compare(b), b.compare(a), a.compare(c): " << a.compare(b) << " " << b.compare(a) << " " << a.compare(c) << " (expected: 1 -1 0)" << endl;
+    cout << "-5 < -3: " << (BigInt(-5) < BigInt(-3)) << ", -30 < -4: " << (BigInt(-30) < BigInt(-4)) << " (expected: 1, 1)" << endl;
+#if __cplusplus >= 202002L
+    cout << "(b <=> a) < 0: " << ((b <=> a) < 0) << " (expected: 1)" << endl;
+#endif
+
+    // Prefix keys order like the values, ties aside
+    vector<BigInt> ordered = {BigInt("-123456789012345"), BigInt(-67890), BigInt(-1), zero, BigInt(7),
+                              a, BigInt("123456789012345678"), BigInt("123456789012345679")};
+    bool keysOrdered = true;
+    for (size_t i = 1; i < ordered.size(); i++)
+    {
+        keysOrdered = keysOrdered && ordered[i - 1].sortKey() <= ordered[i].sortKey();
+    }
+    cout << "sortKey is monotonic: " << keysOrdered << " (expected: 1)" << endl;
+    cout << "sortKey ties past 11 digits: " << (ordered[6].sortKey() == ordered[7].sortKey()) << " (expected: 1)" << endl;
+
+    // Around the saturated 24-bit length: 99...9 with 2^24 - 2 digits,
+    // then with 2^24 - 1 digits, then 10...0 with 2^24 digits
+    const size_t saturated = (1u << 24) - 1;
+    BigInt below(string(saturated - 1, '9')), atLimit(string(saturated, '9')), beyond("1" + string(saturated, '0'));
+    cout << "sortKey across the length limit: " << (below.sortKey() < atLimit.sortKey()) << ", "
+         << (atLimit.sortKey() <= beyond.sortKey()) << ", " << ((-beyond).sortKey() <= (-atLimit).sortKey())
+         << " (expected: 1, 1, 1)" << endl;
+    vector<BigInt> huge = {beyond, atLimit, below};
+    parallelSort(huge);
+    cout << "parallelSort across the length limit: " << (huge[0] == below && huge[1] == atLimit && huge[2] == beyond)
+         << " (expected: 1)" << endl;
 }
 
 void runUnaryAndIncrementTests()
@@ -794,6 +6510,621 @@ void runStringValidationTests()
     }
 }
 
+void runPowerAndRootTests()
+{
+    cout << "\n=== POWERS AND ROOTS TESTS ===" << endl;
+
+    cout << "pow(2, 100) = " << pow(BigInt(2), 100) << " (expected: 1267650600228229401496703205376)" << endl;
+    cout << "pow(-3, 5) = " << pow(BigInt(-3), 5) << " (expected: -243)" << endl;
+    cout << "pow(12345, 0) = " << pow(BigInt(12345), 0) << " (expected: 1)" << endl;
+    cout << "pow(999999999, 2) = " << pow(BigInt(999999999), 2) << " (expected: 999999998000000001)" << endl;
+    cout << "pow(-10^9 - 1, 3) = " << pow(BigInt(-1000000001), 3) << " (expected: -1000000003000000003000000001)" << endl;
+    // Squares take their own kernel; check them against x * (x - 1) + x
+    // through Karatsuba levels, maximal carries and an all-zero low half
+    for (const BigInt &x : {pow(BigInt(3), 2000), BigInt(string(900, '9')), pow(BigInt(10), 600) * 7 + 1})
+    {
+        cout << "x * x == x * (x - 1) + x for " << x.digitCount() << " digits: " << (x * x == x * (x - 1) + x)
+             << " (expected: 1)" << endl;
+    }
+
+    cout << "\nInteger square roots:" << endl;
+    cout << "isqrt(0) = " << isqrt(BigInt(0)) << " (expected: 0)" << endl;
+    cout << "isqrt(99) = " << isqrt(BigInt(99)) << " (expected: 9)" << endl;
+    cout << "isqrt(10^40) = " << isqrt(pow(BigInt(10), 40)) << " (expected: 100000000000000000000)" << endl;
+    BigInt big("123456789012345678901234567890123456789");
+    cout << "isqrt(" << big << ") = " << isqrt(big) << " (expected: 11111111061111110993)" << endl;
+    BigInt square = big * big;
+    cout << "isqrt(big * big) == big: " << (isqrt(square) == big) << " (expected: 1)" << endl;
+    cout << "isqrt(big * big - 1) == big - 1: " << (isqrt(square - BigInt(1)) == big - BigInt(1)) << " (expected: 1)" << endl;
+
+    cout << "\nInteger k-th roots:" << endl;
+    cout << "iroot(1000, 3) = " << iroot(BigInt(1000), 3) << " (expected: 10)" << endl;
+    cout << "iroot(999, 3) = " << iroot(BigInt(999), 3) << " (expected: 9)" << endl;
+    cout << "iroot(-32, 5) = " << iroot(BigInt(-32), 5) << " (expected: -2)" << endl;
+    cout << "iroot(2^100, 10) = " << iroot(pow(BigInt(2), 100), 10) << " (expected: 1024)" << endl;
+    cout << "iroot(big^7 + 1, 7) == big: " << (iroot(pow(big, 7) + BigInt(1), 7) == big) << " (expected: 1)" << endl;
+
+    cout << "\nPerfect squares:" << endl;
+    cout << "isPerfectSquare(144) = " << isPerfectSquare(BigInt(144)) << " (expected: 1)" << endl;
+    cout << "isPerfectSquare(145) = " << isPerfectSquare(BigInt(145)) << " (expected: 0)" << endl;
+    cout << "isPerfectSquare(big * big) = " << isPerfectSquare(square) << " (expected: 1)" << endl;
+    cout << "isPerfectSquare(big * big + 1) = " << isPerfectSquare(square + BigInt(1)) << " (expected: 0)" << endl;
+    cout << "isPerfectSquare(-4) = " << isPerfectSquare(BigInt(-4)) << " (expected: 0)" << endl;
+
+    cout << "\nDomain errors:" << endl;
+    try
+    {
+        isqrt(BigInt(-1));
+        cout << "ERROR: isqrt(-1) should have thrown exception" << endl;
+    }
+    catch (const runtime_error &e)
+    {
+        cout << "isqrt(-1) correctly caught: " << e.what() << endl;
+    }
+    try
+    {
+        iroot(BigInt(-16), 4);
+        cout << "ERROR: iroot(-16, 4) should have thrown exception" << endl;
+    }
+    catch (const runtime_error &e)
+    {
+        cout << "iroot(-16, 4) correctly caught: " << e.what() << endl;
+    }
+}
+
+void runProductAndFactorialTests()
+{
+    cout << "\n=== PRODUCTS AND FACTORIALS TESTS ===" << endl;
+
+    cout << "0! = " << factorial(0) << " (expected: 1)" << endl;
+    cout << "20! = " << factorial(20) << " (expected: 2432902008176640000)" << endl;
+    cout << "30! = " << factorial(30) << " (expected: 265252859812191058636308480000000)" << endl;
+
+    BigInt sequential(1);
+    for (int64_t i = 2; i <= 500; i++)
+    {
+        sequential *= BigInt(i);
+    }
+    cout << "500! matches sequential product: " << (factorial(500) == sequential) << " (expected: 1)" << endl;
+
+    cout << "\nBinomial coefficients:" << endl;
+    cout << "C(10, 3) = " << binomial(10, 3) << " (expected: 120)" << endl;
+    cout << "C(100, 50) = " << binomial(100, 50) << " (expected: 100891344545564193334812497256)" << endl;
+    cout << "C(5, 7) = " << binomial(5, 7) << " (expected: 0)" << endl;
+
+    cout << "\nPrimorials and products:" << endl;
+    cout << "primorial(30) = " << primorial(30) << " (expected: 6469693230)" << endl;
+    cout << "primorial(1) = " << primorial(1) << " (expected: 1)" << endl;
+    vector<BigInt> values = {BigInt(-2), BigInt("12345678901234567890"), BigInt(5)};
+    cout << "product(-2, 12345678901234567890, 5) = " << product(values) << " (expected: -123456789012345678900)" << endl;
+    cout << "product of empty range = " << product(vector<BigInt>()) << " (expected: 1)" << endl;
+}
+
+void runScalarArithmeticTests()
+{
+    cout << "\n=== NATIVE INTEGER OPERAND TESTS ===" << endl;
+
+    BigInt x("123456789012345678901234567890");
+    cout << "x = " << x << endl;
+    cout << "x + 1 = " << (x + 1) << " (expected: 123456789012345678901234567891)" << endl;
+    cout << "x - 1 = " << (x - 1) << " (expected: 123456789012345678901234567889)" << endl;
+    cout << "x * 10 = " << (x * 10) << " (expected: 1234567890123456789012345678900)" << endl;
+    cout << "x / 1000 = " << (x / 1000) << " (expected: 123456789012345678901234567)" << endl;
+    cout << "x % 11 = " << (x % 11) << " (expected: 7)" << endl;
+    cout << "-x % 11 = " << (-x % 11) << " (expected: -7)" << endl;
+    cout << "x * -3 = " << (x * -3) << " (expected: -370370367037037036703703703670)" << endl;
+    cout << "x / UINT64_MAX = " << (x / UINT64_MAX) << " (expected: 6692605942)" << endl;
+
+    cout << "\nSign changes and carries:" << endl;
+    cout << "5 - 10 = " << (BigInt(5) - 10) << " (expected: -5)" << endl;
+    cout << "-5 + 10 = " << (BigInt(-5) + 10) << " (expected: 5)" << endl;
+    cout << "999 + 1 = " << (BigInt(999) + 1) << " (expected: 1000)" << endl;
+    cout << "1000 - 1 = " << (BigInt(1000) - 1) << " (expected: 999)" << endl;
+    cout << "0 + INT64_MIN = " << (BigInt(0) + INT64_MIN) << " (expected: -9223372036854775808)" << endl;
+    cout << "-7 + 0 = " << (BigInt(-7) + BigInt(0)) << " (expected: -7)" << endl;
+
+    cout << "\nCompound forms:" << endl;
+    BigInt y(100);
+    y += 23;
+    y *= 4;
+    y -= 2;
+    y /= 7;
+    cout << "((100 + 23) * 4 - 2) / 7 = " << y << " (expected: 70)" << endl;
+    y %= 8;
+    cout << "70 % 8 = " << y << " (expected: 6)" << endl;
+
+    cout << "\ndivmodSmall:" << endl;
+    BigInt q("-1000000000000000000007");
+    int64_t r = q.divmodSmall(10);
+    cout << "-1000000000000000000007 divmod 10 = " << q << ", " << r << " (expected: -100000000000000000000, -7)" << endl;
+
+    try
+    {
+        BigInt result = x / 0;
+        cout << "ERROR: Division by zero should have thrown exception" << endl;
+    }
+    catch (const runtime_error &e)
+    {
+        cout << "Division by native zero correctly caught: " << e.what() << endl;
+    }
+}
+
+void runSharedStorageTests()
+{
+    cout << "\n=== SHARED (COPY-ON-WRITE) STORAGE TESTS ===" << endl;
+
+    BigInt original = pow(BigInt(7), 1000);
+    BigInt copy = original;
+#ifndef TITANINT_DEEP_COPY
+    cout << "copy shares storage: " << copy.sharesStorage() << " (expected: 1)" << endl;
+#endif
+
+    copy += 1;
+    cout << "copy after += 1 shares storage: " << copy.sharesStorage() << " (expected: 0)" << endl;
+    cout << "original unchanged: " << (original == pow(BigInt(7), 1000)) << " (expected: 1)" << endl;
+    cout << "copy - original = " << (copy - original) << " (expected: 1)" << endl;
+
+    BigInt assigned;
+    assigned = original;
+    assigned.shiftDigitsRight(10);
+    cout << "original unchanged after shifting an assigned copy: " << (original == pow(BigInt(7), 1000)) << " (expected: 1)" << endl;
+
+    vector<BigInt> many(1000, original);
+    many[500] *= 2;
+    cout << "mutating one vector element leaves the rest equal: " << (many[0] == original && many[999] == original && many[500] == original * 2) << " (expected: 1)" << endl;
+
+    cout << "\nSharing across threads:" << endl;
+    vector<thread> workers;
+    vector<BigInt> results(4);
+    for (int t = 0; t < 4; t++)
+    {
+        workers.emplace_back([&original, &results, t]()
+                             {
+            BigInt local = original; // shared copy, then private mutation
+            local += t;
+            results[t] = local - original; });
+    }
+    for (thread &worker : workers)
+    {
+        worker.join();
+    }
+    cout << "per-thread results: " << results[0] << " " << results[1] << " " << results[2] << " " << results[3] << " (expected: 0 1 2 3)" << endl;
+}
+
+void runHashingAndInterningTests()
+{
+    cout << "\n=== HASHING AND INTERNING TESTS ===" << endl;
+
+    BigInt a("123456789012345678901234567890");
+    BigInt b("123456789012345678901234567890");
+    BigInt c = -a;
+    hash<BigInt> hasher;
+    cout << "equal values hash equally: " << (hasher(a) == hasher(b)) << " (expected: 1)" << endl;
+    cout << "sign changes the hash: " << (hasher(a) != hasher(c)) << " (expected: 1)" << endl;
+
+    BigInt mutated = a;
+    size_t before = hasher(mutated);
+    mutated += 1;
+    cout << "hash recomputed after mutation: " << (hasher(mutated) != before) << " (expected: 1)" << endl;
+    cout << "hash matches a fresh value: " << (hasher(mutated) == hasher(BigInt("123456789012345678901234567891"))) << " (expected: 1)" << endl;
+
+    unordered_map<BigInt, int> counts;
+    for (int64_t i = 0; i < 1000; i++)
+    {
+        counts[BigInt(i % 100) * a]++;
+    }
+    cout << "distinct keys in unordered_map: " << counts.size() << " (expected: 100)" << endl;
+    cout << "count for 7 * a: " << counts[a * 7] << " (expected: 10)" << endl;
+
+    cout << "\nInterning:" << endl;
+    BigInt ia = a.interned();
+    BigInt ib = b.interned();
+    BigInt ic = c.interned();
+#ifndef TITANINT_DEEP_COPY
+    cout << "interned copies are interned: " << (ia.isInterned() && ib.isInterned()) << " (expected: 1)" << endl;
+#endif
+    cout << "ia == ib: " << (ia == ib) << " (expected: 1)" << endl;
+    cout << "ia == ic: " << (ia == ic) << " (expected: 0)" << endl;
+    cout << "ic = " << ic << " (expected: -123456789012345678901234567890)" << endl;
+    cout << "(a + 1).interned() == ia: " << ((a + 1).interned() == ia) << " (expected: 0)" << endl;
+
+    BigInt changed = ia;
+    changed *= 2;
+    cout << "mutating an interned value leaves the canonical copy intact: " << (ia == a && !changed.isInterned()) << " (expected: 1)" << endl;
+
+    // Both values are new to the table; the first is then changed into
+    // the second's value
+    BigInt first = BigInt("918273645546372819").interned();
+    first += 1;
+    BigInt second = BigInt("918273645546372820").interned();
+    cout << "an interned value changed to equal another interned value: " << (first == second) << " (expected: 1)" << endl;
+}
+
+void runRationalTests()
+{
+    cout << "\n=== RATIONAL NUMBER TESTS ===" << endl;
+
+    cout << "gcd(462, 1071) = " << gcd(BigInt(462), BigInt(1071)) << " (expected: 21)" << endl;
+    cout << "gcd(-48, 180) = " << gcd(BigInt(-48), BigInt(180)) << " (expected: 12)" << endl;
+    cout << "gcd(0, 5) = " << gcd(BigInt(0), BigInt(5)) << " (expected: 5)" << endl;
+
+    BigRational half(BigInt(1), BigInt(2));
+    BigRational third("1/3");
+    cout << "\n1/2 + 1/3 = " << (half + third) << " (expected: 5/6)" << endl;
+    cout << "1/2 - 1/3 = " << (half - third) << " (expected: 1/6)" << endl;
+    cout << "1/2 * 1/3 = " << (half * third) << " (expected: 1/6)" << endl;
+    cout << "1/2 / 1/3 = " << (half / third) << " (expected: 3/2)" << endl;
+    cout << "6/-4 = " << BigRational(BigInt(6), BigInt(-4)) << " (expected: -3/2)" << endl;
+    cout << "4/2 = " << BigRational("4/2") << " (expected: 2)" << endl;
+
+    cout << "\nComparisons:" << endl;
+    cout << "1/3 < 1/2: " << (third < half) << " (expected: 1)" << endl;
+    cout << "2/4 == 1/2: " << (BigRational("2/4") == half) << " (expected: 1)" << endl;
+    cout << "-1/2 > -1/3: " << (-half > -third) << " (expected: 0)" << endl;
+    BigRational tiny(BigInt(1), pow(BigInt(10), 100));
+    cout << "1/10^100 < 1/3 (decided by digit counts): " << (tiny < third) << " (expected: 1)" << endl;
+
+    cout << "\nLazy reduction:" << endl;
+    BigRational harmonic;
+    for (int64_t i = 1; i <= 30; i++)
+    {
+        harmonic += BigRational(BigInt(1), BigInt(i));
+    }
+    cout << "H(30) = " << harmonic << " (expected: 9304682830147/2329089562800)" << endl;
+    BigRational sum = half + half;
+    cout << "1/2 + 1/2 reduced before printing: " << sum.isReduced() << " (expected: 0)" << endl;
+    cout << "1/2 + 1/2 = " << sum << " (expected: 1)" << endl;
+
+    try
+    {
+        BigRational bad(BigInt(1), BigInt(0));
+        cout << "ERROR: zero denominator should have thrown exception" << endl;
+    }
+    catch (const runtime_error &e)
+    {
+        cout << "Zero denominator correctly caught: " << e.what() << endl;
+    }
+}
+
+void runDecimalTests()
+{
+    cout << "\n=== DECIMAL FIXED POINT TESTS ===" << endl;
+
+    BigDecimal price("19.99");
+    BigDecimal rate("0.0725");
+    cout << "19.99 + 0.0725 = " << (price + rate) << " (expected: 20.0625)" << endl;
+    cout << "19.99 - 0.0725 = " << (price - rate) << " (expected: 19.9175)" << endl;
+    cout << "19.99 * 0.0725 = " << (price * rate) << " (expected: 1.449275)" << endl;
+    cout << "tax rounded to cents = " << (price * rate).setScale(2) << " (expected: 1.45)" << endl;
+    cout << "1.5 at scale 3 = " << BigDecimal("1.5").setScale(3) << " (expected: 1.500)" << endl;
+    cout << "-.5 = " << BigDecimal("-.5") << " (expected: -0.5)" << endl;
+
+    cout << "\nRounding modes (2.5 / -2.5 / 2.51 to scale 0):" << endl;
+    BigDecimal tie("2.5"), negTie("-2.5"), above("2.51");
+    cout << "HALF_EVEN: " << tie.setScale(0, ROUND_HALF_EVEN) << " " << negTie.setScale(0, ROUND_HALF_EVEN) << " " << above.setScale(0, ROUND_HALF_EVEN) << " (expected: 2 -2 3)" << endl;
+    cout << "HALF_UP: " << tie.setScale(0, ROUND_HALF_UP) << " " << negTie.setScale(0, ROUND_HALF_UP) << " " << above.setScale(0, ROUND_HALF_UP) << " (expected: 3 -3 3)" << endl;
+    cout << "HALF_DOWN: " << tie.setScale(0, ROUND_HALF_DOWN) << " " << negTie.setScale(0, ROUND_HALF_DOWN) << " " << above.setScale(0, ROUND_HALF_DOWN) << " (expected: 2 -2 3)" << endl;
+    cout << "CEILING: " << tie.setScale(0, ROUND_CEILING) << " " << negTie.setScale(0, ROUND_CEILING) << " " << above.setScale(0, ROUND_CEILING) << " (expected: 3 -2 3)" << endl;
+    cout << "FLOOR: " << tie.setScale(0, ROUND_FLOOR) << " " << negTie.setScale(0, ROUND_FLOOR) << " " << above.setScale(0, ROUND_FLOOR) << " (expected: 2 -3 2)" << endl;
+
+    cout << "\nDivision:" << endl;
+    cout << "1 / 3 at scale 5 = " << BigDecimal(1).divide(BigDecimal(3), 5) << " (expected: 0.33333)" << endl;
+    cout << "2 / 3 at scale 5 = " << BigDecimal(2).divide(BigDecimal(3), 5) << " (expected: 0.66667)" << endl;
+    cout << "-0.125 / 1 at scale 2 (HALF_EVEN) = " << BigDecimal("-0.125").divide(BigDecimal(1), 2) << " (expected: -0.12)" << endl;
+    cout << "-0.1251 / 1 at scale 2 (HALF_EVEN) = " << BigDecimal("-0.1251").divide(BigDecimal(1), 2) << " (expected: -0.13)" << endl;
+
+    cout << "\nComparison and batch sums:" << endl;
+    cout << "1.50 == 1.5: " << (BigDecimal("1.50") == BigDecimal("1.5")) << " (expected: 1)" << endl;
+    cout << "compare(1.49, 1.5), compare(1.5, 1.49): " << BigDecimal::compare(BigDecimal("1.49"), BigDecimal("1.5")) << ", "
+         << BigDecimal::compare(BigDecimal("1.5"), BigDecimal("1.49")) << " (expected: -1, 1)" << endl;
+    cout << "compare(-2.000, -2.01), compare(-3, -2.5): " << BigDecimal::compare(BigDecimal("-2.000"), BigDecimal("-2.01")) << ", "
+         << BigDecimal::compare(BigDecimal("-3"), BigDecimal("-2.5")) << " (expected: 1, -1)" << endl;
+    cout << "1.50 stripped = " << BigDecimal("1.50").stripTrailingZeros() << " (expected: 1.5)" << endl;
+    vector<BigDecimal> ledger;
+    for (int i = 0; i < 1000; i++)
+    {
+        ledger.push_back(BigDecimal("0.01"));
+    }
+    ledger.push_back(BigDecimal("-0.005"));
+    cout << "1000 x 0.01 - 0.005 = " << batchSum(ledger) << " (expected: 9.995)" << endl;
+}
+
+void runFloatTests()
+{
+    cout << "\n=== FLOATING POINT TESTS ===" << endl;
+
+    BigFloat third = BigFloat(1, 30) / BigFloat(3, 30);
+    cout << "1 / 3 (30 digits) = " << third << " (expected: 0.333333333333333333333333333333)" << endl;
+    cout << "2 / 3 (30 digits) = " << BigFloat(2, 30) / BigFloat(3, 30) << " (expected: 0.666666666666666666666666666667)" << endl;
+    cout << "sqrt(2) (50 digits) = " << sqrt(BigFloat(2, 50)) << endl;
+    cout << "  (expected: 1.4142135623730950488016887242096980785696718753769)" << endl;
+    cout << "0.125 at 2 digits = " << BigFloat("0.125", 2) << " (expected: 0.12, ties to even)" << endl;
+    cout << "0.135 at 2 digits = " << BigFloat("0.135", 2) << " (expected: 0.14, ties to even)" << endl;
+    cout << "1e100 + 1e-100 = " << BigFloat("1e100") + BigFloat("1e-100") << " (expected: 1e100)" << endl;
+    cout << "1 - 1e-60 (50 digits) = " << BigFloat(1) - BigFloat("1e-60") << " (expected: 1)" << endl;
+    cout << "1.5e-20 * 2 = " << BigFloat("1.5e-20") * BigFloat(2) << " (expected: 3e-20)" << endl;
+
+    cout << "\nConstants and elementary functions (50 digits):" << endl;
+    cout << "pi = " << pi(50) << endl;
+    cout << "  (expected: 3.1415926535897932384626433832795028841971693993751)" << endl;
+    cout << "exp(1) = " << exp(BigFloat(1, 50)) << endl;
+    cout << "  (expected: 2.7182818284590452353602874713526624977572470937)" << endl;
+    cout << "log(10) = " << log(BigFloat(10, 50)) << endl;
+    cout << "  (expected: 2.3025850929940456840179914546843642076011014886288)" << endl;
+    cout << "exp(log(2)) = " << exp(log(BigFloat(2, 40))) << " (expected: 2)" << endl;
+    cout << "exp(1e-45) = " << exp(BigFloat("1e-45")) << " (expected: 1.000000000000000000000000000000000000000000001)" << endl;
+    cout << "exp(-1e-45) = " << exp(BigFloat("-1e-45")) << " (expected: 0.999999999999999999999999999999999999999999999)" << endl;
+    cout << "exp(+-1e-1000000000) = " << exp(BigFloat("1e-1000000000")) << ", " << exp(BigFloat("-1e-1000000000"))
+         << " (expected: 1, 1)" << endl;
+
+    cout << "\nComparison:" << endl;
+    cout << "2.50 == 2.5: " << (BigFloat("2.50") == BigFloat("2.5")) << " (expected: 1)" << endl;
+    cout << "-1e-5 < 1e-6: " << (BigFloat("-1e-5") < BigFloat("1e-6")) << " (expected: 1)" << endl;
+    try
+    {
+        sqrt(BigFloat(-1));
+    }
+    catch (const runtime_error &e)
+    {
+        cout << "sqrt(-1): caught \"" << e.what() << "\"" << endl;
+    }
+}
+
+void runRnsTests()
+{
+    cout << "\n=== RESIDUE NUMBER SYSTEM TESTS ===" << endl;
+
+    auto basis = make_shared<const RnsBasis>(100);
+    cout << "Basis for 100 digits: " << basis->size() << " primes, largest " << basis->moduli()[0] << " (expected: 2147483647)" << endl;
+
+    BigInt a("123456789012345678901234567890");
+    BigInt b("-987654321098765432109876543210");
+    RnsInt ra(basis, a), rb(basis, b);
+    cout << "a * b via RNS == a * b: " << ((ra * rb).toBigInt() == a * b) << " (expected: 1)" << endl;
+    cout << "a + b via RNS = " << (ra + rb).toBigInt() << " (expected: " << a + b << ")" << endl;
+    cout << "a - b via RNS = " << (ra - rb).toBigInt() << " (expected: " << a - b << ")" << endl;
+    cout << "-a via RNS = " << (-ra).toBigInt() << " (expected: " << -a << ")" << endl;
+
+    // A product chain stays in residue form until the end
+    auto wide = make_shared<const RnsBasis>(200);
+    vector<BigInt> factors;
+    for (int i = 1; i <= 100; i++)
+    {
+        factors.push_back(BigInt(i));
+    }
+    vector<RnsInt> residues = toRns(wide, factors);
+    RnsInt chain = residues[0];
+    for (size_t i = 1; i < residues.size(); i++)
+    {
+        chain *= residues[i];
+    }
+    cout << "100! via RNS == factorial(100): " << (chain.toBigInt() == factorial(100)) << " (expected: 1)" << endl;
+
+    // Outside the basis range values wrap modulo M
+    RnsInt tooBig(basis, pow(BigInt(10), 60));
+    cout << "10^120 in a 100 digit basis wraps: " << ((tooBig * tooBig).toBigInt() != pow(BigInt(10), 120)) << " (expected: 1)" << endl;
+    try
+    {
+        RnsInt mixed = ra * RnsInt(wide, a);
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << "Mixed bases: caught \"" << e.what() << "\"" << endl;
+    }
+}
+
+void runRemainderTreeTests()
+{
+    cout << "\n=== REMAINDER TREE TESTS ===" << endl;
+
+    BigInt x = factorial(200) + 12345;
+    vector<BigInt> moduli;
+    for (int m : {7, 11, 13, 97, 1009})
+    {
+        moduli.push_back(BigInt(m));
+    }
+    moduli.push_back(pow(BigInt(10), 30) + 57);
+    vector<BigInt> r = remainders(x, moduli);
+    cout << "200! + 12345 mod 7, 11, 13, 97, 1009 = " << r[0] << ", " << r[1] << ", " << r[2] << ", " << r[3] << ", " << r[4];
+    cout << " (expected: " << x % 7 << ", " << x % 11 << ", " << x % 13 << ", " << x % 97 << ", " << x % 1009 << ")" << endl;
+    cout << "... mod 10^30 + 57 matches operator%: " << (r[5] == x % moduli[5]) << " (expected: 1)" << endl;
+    cout << "Negative x keeps operator% signs: " << (remainders(-x, moduli)[3] == (-x) % 97) << " (expected: 1)" << endl;
+
+    // Large division goes through the Newton reciprocal
+    BigInt big = pow(BigInt(3), 2000) + 1;
+    BigInt divisor = pow(BigInt(7), 300) - 2;
+    BigInt q = big / divisor, rem = big % divisor;
+    cout << "3^2000 + 1 == q * (7^300 - 2) + r with 0 <= r < d: "
+         << (q * divisor + rem == big && !rem.getIsNegative() && rem < divisor) << " (expected: 1)" << endl;
+
+    // Two of these moduli share the prime 1000000007
+    BigInt p("1000000007"), q1("998244353"), q2("1000000009"), q3("999999937");
+    vector<BigInt> keys = {p * q1, q2 * q3, BigInt("1000000021") * BigInt("1000000033"), p * q3};
+    vector<BigInt> shared = batchGcd(keys);
+    cout << "batchGcd = " << shared[0] << ", " << shared[1] << ", " << shared[2] << ", " << shared[3]
+         << " (expected: 1000000007, 999999937, 1, 999999943999999559)" << endl;
+}
+
+void runContainerAlgorithmTests()
+{
+    cout << "\n=== CONTAINER ALGORITHM TESTS ===" << endl;
+
+    BigInt acc("999999999999");
+    acc += BigInt(1);
+    cout << "999999999999 += 1 = " << acc << " (expected: 1000000000000)" << endl;
+    BigInt twice("-123456789");
+    twice += twice;
+    cout << "-123456789 += itself = " << twice << " (expected: -246913578)" << endl;
+    BigInt fromZero;
+    fromZero += BigInt(-5);
+    cout << "0 += -5 = " << fromZero << " (expected: -5)" << endl;
+
+    vector<BigInt> values;
+    for (int i = 0; i < 20000; i++)
+    {
+        values.push_back(pow(BigInt(-3), i % 40) * (i % 7 + 1) + i);
+    }
+    // Same 11-digit prefix and length: only compare() can order these
+    values.push_back(BigInt("123456789012345"));
+    values.push_back(BigInt("123456789012344"));
+
+    vector<BigInt> expected = values;
+    sort(expected.begin(), expected.end());
+    vector<BigInt> sorted = values;
+    parallelSort(sorted);
+    cout << "parallelSort matches std::sort: " << (sorted == expected) << " (expected: 1)" << endl;
+
+    BigInt sum;
+    for (const BigInt &v : values)
+    {
+        sum = sum + v;
+    }
+    cout << "parallelSum matches a sequential sum: " << (parallelSum(values) == sum) << " (expected: 1)" << endl;
+
+    Accumulator left, right;
+    left.reserve(100);
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        (i % 2 ? left : right) += values[i];
+    }
+    left.merge(right);
+    cout << "Accumulator halves merged match the sum: " << (left.finalize() == sum) << ", " << left.count()
+         << " terms (expected: 1, 20002 terms)" << endl;
+    Accumulator carries;
+    for (int i = 0; i < 1000; i++)
+    {
+        carries += BigInt("999999999999999999");
+    }
+    carries += BigInt(-999);
+    cout << "1000 * (10^18 - 1) - 999 = " << carries.finalize() << " (expected: 999999999999999998001)" << endl;
+
+    pair<BigInt, BigInt> range = parallelMinMax(values);
+    cout << "parallelMinMax matches the sorted ends: " << (range.first == expected.front() && range.second == expected.back())
+         << " (expected: 1)" << endl;
+    try
+    {
+        parallelMinMax(vector<BigInt>());
+        cout << "parallelMinMax of nothing: no exception (expected: exception)" << endl;
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << "parallelMinMax of nothing: " << e.what() << " (expected: exception)" << endl;
+    }
+}
+
+void runDivisorTests()
+{
+    cout << "\n=== DIVISOR TESTS ===" << endl;
+
+    Divisor seven(BigInt(-7));
+    cout << "100 / -7, 100 % -7 = " << BigInt(100) / seven << ", " << BigInt(100) % seven << " (expected: -14, 2)" << endl;
+    pair<BigInt, BigInt> qr = divmod(BigInt(-100), BigInt(7));
+    cout << "divmod(-100, 7) = " << qr.first << ", " << qr.second << " (expected: -14, -2)" << endl;
+
+    // A large divisor keeps its Newton reciprocal across calls, and grows
+    // it for a dividend longer than it was prepared for
+    BigInt big = pow(BigInt(10), 40) + 7;
+    Divisor prepared(big, 100);
+    bool matches = true;
+    for (uint64_t e : {50, 90, 300})
+    {
+        BigInt a = pow(BigInt(3), e) - 1;
+        matches = matches && a / prepared == a / big && a % prepared == a % big;
+    }
+    cout << "Prepared 10^40 + 7 matches / and %: " << matches << " (expected: 1)" << endl;
+
+    cout << "powMod(2, 1000, 10^40 + 7) matches pow then %: "
+         << (powMod(BigInt(2), BigInt(1000), prepared) == pow(BigInt(2), 1000) % big) << " (expected: 1)" << endl;
+    cout << "powMod(3, 10^18, 1000000007) = " << powMod(BigInt(3), pow(BigInt(10), 18), Divisor(BigInt(1000000007)))
+         << " (expected: 246336683)" << endl;
+
+    DivisorCache cache(2);
+    shared_ptr<const Divisor> first = cache.get(big);
+    cache.get(BigInt(11));
+    cache.get(big);
+    cache.get(BigInt(13)); // evicts 11, the least recently used
+    cout << "LRU cache keeps the reused divisor: " << (cache.get(big) == first) << ", size " << cache.size()
+         << " (expected: 1, size 2)" << endl;
+
+    try
+    {
+        Divisor zero(BigInt(0));
+        cout << "Divisor(0): no exception (expected: exception)" << endl;
+    }
+    catch (const runtime_error &e)
+    {
+        cout << "Divisor(0): " << e.what() << " (expected: exception)" << endl;
+    }
+}
+
+void runMemoryTests()
+{
+    cout << "\n=== MEMORY FOOTPRINT TESTS ===" << endl;
+
+    vector<BigInt> values;
+    for (int i = 0; i < 1000; i++)
+    {
+        values.push_back(pow(BigInt(7), 40 + i % 10) + i);
+    }
+    MemoryStats before = memoryStats();
+    vector<BigInt> copies = values; // shares every buffer
+    MemoryStats during = memoryStats();
+#ifndef TITANINT_DEEP_COPY
+    cout << "1000 copies: +" << during.liveObjects - before.liveObjects << " objects, +"
+         << during.liveBuffers - before.liveBuffers << " buffers, +" << during.liveBytes - before.liveBytes
+         << " bytes (expected: +1000 objects, +0 buffers, +0 bytes)" << endl;
+#else
+    cout << "1000 copies: +" << during.liveObjects - before.liveObjects << " objects, +"
+         << during.liveBuffers - before.liveBuffers << " buffers (expected: +1000 objects, +1000 buffers)" << endl;
+#endif
+
+    size_t full = 0, compact = 0;
+    vector<CompactBigInt> packed;
+    for (const BigInt &value : values)
+    {
+        packed.emplace_back(value);
+        full += value.memoryUsage();
+        compact += packed.back().memoryUsage();
+    }
+    bool roundTrip = true;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        roundTrip = roundTrip && packed[i].toBigInt() == values[i];
+    }
+    cout << "CompactBigInt round trip: " << roundTrip << ", at least 2x smaller: " << (full >= 2 * compact)
+         << " (expected: 1, 1)" << endl;
+    cout << "CompactBigInt(-12345).toBigInt() = " << CompactBigInt(BigInt(-12345)).toBigInt() << " (expected: -12345)" << endl;
+    CompactBigInt source(values[0]);
+    CompactBigInt moved(move(source));
+    CompactBigInt copyOfMovedFrom(source);
+    cout << "Moved-from CompactBigInt: " << source.toBigInt() << ", " << copyOfMovedFrom.toBigInt() << ", "
+         << (source == CompactBigInt()) << "; moved value intact: " << (moved.toBigInt() == values[0])
+         << " (expected: 0, 0, 1; 1)" << endl;
+    source = moved;
+    cout << "Moved-from CompactBigInt reassigned: " << (source.toBigInt() == values[0]) << " (expected: 1)" << endl;
+
+    BigInt grown(1);
+    for (int i = 0; i < 1000; i++)
+    {
+        grown += grown;
+    }
+    size_t beforeShrink = grown.memoryUsage();
+    grown.shrinkToFit();
+    cout << "shrinkToFit after in-place growth frees memory: " << (grown.memoryUsage() < beforeShrink) << " (expected: 1)" << endl;
+    BigInt reserved(5);
+    reserved.reserve(1000);
+    cout << "reserve(1000) keeps the value and grows the buffer: " << reserved << ", " << (reserved.memoryUsage() > 1000)
+         << " (expected: 5, 1)" << endl;
+    size_t reservedBytes = reserved.memoryUsage();
+    reserved.assign("-000123456789");
+    cout << "assign parses into the same buffer: " << reserved << ", " << (reserved.memoryUsage() == reservedBytes)
+         << " (expected: -123456789, 1)" << endl;
+
+    copies.clear();
+    MemoryStats after = memoryStats();
+    cout << "Objects back after clearing the copies: " << (after.liveObjects == before.liveObjects + 2) << " (expected: 1)" << endl;
+}
+
 void runAllTests()
 {
     cout << "\n=== RUNNING ALL COMPREHENSIVE TESTS ===" << endl;
@@ -805,6 +7136,19 @@ void runAllTests()
     runNegativeNumberTests();
     runEdgeCaseTests();
     runStringValidationTests();
+    runPowerAndRootTests();
+    runProductAndFactorialTests();
+    runScalarArithmeticTests();
+    runSharedStorageTests();
+    runHashingAndInterningTests();
+    runRationalTests();
+    runDecimalTests();
+    runFloatTests();
+    runRnsTests();
+    runRemainderTreeTests();
+    runContainerAlgorithmTests();
+    runDivisorTests();
+    runMemoryTests();
 
     cout << "\n All tests completed!" << endl;
     cout << "\nPress Enter to return to main menu...";
@@ -1052,13 +7396,99 @@ void displayMenu()
     cout << "10. Interactive Comparison Calculator" << endl;
     cout << "11. Interactive Unary Operations" << endl;
     cout << "12. Interactive Assignment Operations" << endl;
-    cout << "13. Exit" << endl;
+    cout << "13. Powers & Roots Tests" << endl;
+    cout << "14. Products & Factorials Tests" << endl;
+    cout << "15. Native Integer Operand Tests" << endl;
+    cout << "16. Shared Storage Tests" << endl;
+    cout << "17. Hashing & Interning Tests" << endl;
+    cout << "18. Rational Number Tests" << endl;
+    cout << "19. Decimal Fixed Point Tests" << endl;
+    cout << "20. Floating Point Tests" << endl;
+    cout << "21. Residue Number System Tests" << endl;
+    cout << "22. Remainder Tree Tests" << endl;
+    cout << "23. Container Algorithm Tests" << endl;
+    cout << "24. Divisor Tests" << endl;
+    cout << "25. Memory Footprint Tests" << endl;
+    cout << "26. Exit" << endl;
     cout << "========================================" << endl;
-    cout << "Enter your choice (1-13): ";
+    cout << "Enter your choice (1-26): ";
 }
 
-int main()
+#if defined(TITANINT_PROPERTY_TESTS)
+// Non-interactive: ./TitanInt [seed] [rounds]
+int main(int argc, char *argv[])
+{
+    uint64_t seed = argc > 1 ? stoull(argv[1]) : 1;
+    size_t rounds = argc > 2 ? stoull(argv[2]) : 10;
+    return runPropertyTests(seed, rounds) == 0 ? 0 : 1;
+}
+#elif defined(TITANINT_TUNER)
+// Non-interactive: ./TitanIntTuner [thresholds file]
+int main(int argc, char *argv[])
+{
+    tuneThresholds();
+    string path = argc > 1 ? argv[1] : "titanint_thresholds.txt";
+    ofstream out(path);
+    saveThresholds(out);
+    if (!out)
+    {
+        cerr << "Cannot write " << path << endl;
+        return 1;
+    }
+    cout << "Wrote " << path << endl;
+    return 0;
+}
+#elif !defined(TITANINT_FUZZ)
+int main(int argc, char *argv[])
 {
+    // TitanInt [--thresholds file] ...: tuned crossovers (see TUNING) from
+    // the file, else from $TITANINT_THRESHOLDS; the option is then dropped
+    // so the modes below see their own arguments from argv[1]
+    const char *thresholds = getenv("TITANINT_THRESHOLDS");
+    if (argc > 2 && string(argv[1]) == "--thresholds")
+    {
+        thresholds = argv[2];
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    if (thresholds && *thresholds)
+    {
+        try
+        {
+            loadThresholds(thresholds);
+        }
+        catch (const runtime_error &e)
+        {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+
+    // TitanInt --batch [file]: non-interactive, see BATCH MODE
+    if (argc > 1 && string(argv[1]) == "--batch")
+    {
+        ios::sync_with_stdio(false);
+        if (argc > 2)
+        {
+            ifstream in(argv[2]);
+            if (!in)
+            {
+                cerr << "Cannot open " << argv[2] << endl;
+                return 1;
+            }
+            return runBatch(in, cout) == 0 ? 0 : 2;
+        }
+        return runBatch(cin, cout) == 0 ? 0 : 2;
+    }
+#ifdef __linux__
+    // TitanInt --serve <socket path | port>: see RPC SERVER
+    if (argc > 2 && string(argv[1]) == "--serve")
+    {
+        return runServer(argv[2]);
+    }
+#endif
+
     int choice;
 
     cout << "BigInt Class - Menu-Driven Testing Interface" << endl;
@@ -1070,7 +7500,7 @@ int main()
 
         if (!(cin >> choice))
         {
-            cout << "\nInvalid input! Please enter a number between 1-13." << endl;
+            cout << "\nInvalid input! Please enter a number between 1-26." << endl;
             cin.clear();
             cin.ignore(numeric_limits<streamsize>::max(), '\n');
             continue;
@@ -1117,20 +7547,67 @@ int main()
             performAssignmentOperation();
             break;
         case 13:
+            runPowerAndRootTests();
+            break;
+        case 14:
+            runProductAndFactorialTests();
+            break;
+        case 15:
+            runScalarArithmeticTests();
+            break;
+        case 16:
+            runSharedStorageTests();
+            break;
+        case 17:
+            runHashingAndInterningTests();
+            break;
+        case 18:
+            runRationalTests();
+            break;
+        case 19:
+            runDecimalTests();
+            break;
+        case 20:
+            runFloatTests();
+            break;
+        case 21:
+            runRnsTests();
+            break;
+        case 22:
+            runRemainderTreeTests();
+            break;
+        case 23:
+            runContainerAlgorithmTests();
+            break;
+        case 24:
+            runDivisorTests();
+            break;
+        case 25:
+            runMemoryTests();
+            break;
+        case 26:
             cout << "\nThank you for using BigInt Class Tester!" << endl;
             cout << "Goodbye!" << endl;
             break;
         default:
-            cout << "\nInvalid choice! Please enter a number between 1-13." << endl;
+            cout << "\nInvalid choice! Please enter a number between 1-26." << endl;
             break;
         }
 
-        if (choice != 13)
+        if (choice != 26)
         {
             cout << "\nPress Enter to return to main menu...";
             cin.ignore(numeric_limits<streamsize>::max(), '\n');
         }
 
-    } while (choice != 13);
+    } while (choice != 26);
+
+#ifdef TITANINT_INSTRUMENT
+    // Instrumented builds report what the session spent its time on
+    titan_stats::dumpJSON(cerr);
+    ofstream trace("titanint_trace.json");
+    titan_stats::dumpChromeTrace(trace);
+#endif
     return 0;
 }
+#endif